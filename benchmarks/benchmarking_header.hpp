@@ -0,0 +1,53 @@
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch.hpp>
+
+#include <AvoGUI.hpp>
+
+namespace benchmarks {
+
+inline constexpr auto tree_branching_factor = std::size_t{8};
+
+/*
+	Returns the index of the parent of the node at index, in a tree whose nodes are created 
+	in breadth-first order and all have tree_branching_factor children.
+	The first tree_branching_factor nodes are children of the root, which has no index.
+*/
+[[nodiscard]]
+constexpr std::optional<std::size_t> tree_parent_index(std::size_t const index) noexcept {
+	if (index < tree_branching_factor) {
+		return std::nullopt;
+	}
+	return (index - tree_branching_factor)/tree_branching_factor;
+}
+static_assert(!tree_parent_index(7) && tree_parent_index(8) == 0 && tree_parent_index(15) == 0 && tree_parent_index(16) == 1);
+
+/*
+	Builds a tree of node_count nodes below root, see tree_parent_index.
+	The node at index i is constructed with its parent and make_argument(i), like its ID or component.
+*/
+[[nodiscard]]
+std::vector<std::unique_ptr<avo::Node>> build_tree(
+	avo::Node& root, std::size_t const node_count, 
+	std::invocable<std::size_t> auto const& make_argument
+) {
+	auto nodes = std::vector<std::unique_ptr<avo::Node>>{};
+	nodes.reserve(node_count);
+	for (auto const i : avo::utils::Range{node_count}) {
+		auto const parent_index = tree_parent_index(i);
+		auto& parent = parent_index ? *nodes[*parent_index] : root;
+		nodes.push_back(std::make_unique<avo::Node>(parent, make_argument(i)));
+	}
+	return nodes;
+}
+
+/*
+	Builds a tree where the node at index i has the ID i + 1.
+*/
+[[nodiscard]]
+inline std::vector<std::unique_ptr<avo::Node>> build_tree(avo::Node& root, std::size_t const node_count) {
+	return build_tree(root, node_count, [](std::size_t const i) { 
+		return avo::Id{static_cast<std::uint64_t>(i) + 1}; 
+	});
+}
+
+} // namespace benchmarks
@@ -0,0 +1,33 @@
+#include "benchmarking_header.hpp"
+
+namespace {
+
+template<avo::unicode::IsCodePoint T>
+void benchmark_character_count(std::basic_string_view<T> const sample, std::size_t const size) {
+	auto string = std::basic_string<T>{};
+	while (string.size() < size) {
+		string += sample;
+	}
+	auto const view = std::basic_string_view<T>{string};
+
+	BENCHMARK("Scalar count") {
+		return std::ranges::count_if(view, [](T const code_point) {
+			return avo::unicode::is_first_code_point(code_point);
+		});
+	};
+	BENCHMARK("avo::unicode::character_count") {
+		return avo::unicode::character_count(view);
+	};
+}
+
+constexpr auto utf8_sample = "Hello AvoGUI! مجفف شعر أم مكنسة كهربائية؟ 🪢 här √ är knut. "sv;
+constexpr auto utf16_sample = u"Hello AvoGUI! مجفف شعر أم مكنسة كهربائية؟ 🪢 här √ är knut. "sv;
+
+} // namespace
+
+TEST_CASE("Character count of 1 MiB of UTF-8") {
+	benchmark_character_count(utf8_sample, 1 << 20);
+}
+TEST_CASE("Character count of 1 MiB of UTF-16") {
+	benchmark_character_count(utf16_sample, 1 << 19);
+}
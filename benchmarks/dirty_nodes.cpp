@@ -0,0 +1,54 @@
+#include "benchmarking_header.hpp"
+
+TEST_CASE("Finding 10 dirty nodes in a tree of 30000 nodes") {
+	auto root = avo::Node{};
+	auto const nodes = benchmarks::build_tree(root, 30000);
+
+	auto engine = std::mt19937{};
+	auto changed_nodes = std::vector<avo::Node*>(10);
+	std::ranges::generate(changed_nodes, [&] {
+		return nodes[std::uniform_int_distribution<std::size_t>{0, nodes.size() - 1}(engine)].get();
+	});
+	auto const mark_changed_nodes = [&] {
+		for (auto* const node : changed_nodes) {
+			node->mark_dirty();
+		}
+	};
+
+	BENCHMARK("Checking every node") {
+		mark_changed_nodes();
+		// Only finds the nodes, the flags are left as they are.
+		auto count = 0;
+		for (auto const& node : root | avo::utils::flatten) {
+			count += node.is_dirty();
+		}
+		return count;
+	};
+	BENCHMARK("avo::dirty_nodes") {
+		mark_changed_nodes();
+		return std::ranges::distance(avo::dirty_nodes(root));
+	};
+}
+
+TEST_CASE("Finding 10 dirty nodes among 30000 children of a node") {
+	auto root = avo::Node{};
+
+	auto nodes = std::vector<std::unique_ptr<avo::Node>>{};
+	nodes.reserve(30000);
+	for (auto const i : avo::utils::Range{30000}) {
+		nodes.push_back(std::make_unique<avo::Node>(root, avo::Id{static_cast<std::uint64_t>(i) + 1}));
+	}
+
+	auto engine = std::mt19937{};
+	auto changed_nodes = std::vector<avo::Node*>(10);
+	std::ranges::generate(changed_nodes, [&] {
+		return nodes[std::uniform_int_distribution<std::size_t>{0, nodes.size() - 1}(engine)].get();
+	});
+
+	BENCHMARK("avo::dirty_nodes") {
+		for (auto* const node : changed_nodes) {
+			node->mark_dirty();
+		}
+		return std::ranges::distance(avo::dirty_nodes(root));
+	};
+}
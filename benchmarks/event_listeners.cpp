@@ -0,0 +1,74 @@
+#include "benchmarking_header.hpp"
+
+namespace {
+
+/*
+	The way EventListeners used to store and call its listeners.
+*/
+template<typename ... _Arguments>
+class StdFunctionListeners {
+public:
+	void add(std::function<void(_Arguments...)> listener) {
+		auto const lock = std::scoped_lock{_mutex};
+		_listeners.push_back(std::move(listener));
+	}
+	void notify_all(_Arguments&& ... arguments) {
+		auto const lock = std::scoped_lock{_mutex};
+		for (auto& listener : _listeners) {
+			listener(std::forward<_Arguments>(arguments)...);
+		}
+	}
+	std::size_t size() {
+		auto const lock = std::scoped_lock{_mutex};
+		return _listeners.size();
+	}
+
+private:
+	std::recursive_mutex _mutex;
+	std::vector<std::function<void(_Arguments...)>> _listeners;
+};
+
+} // namespace
+
+TEST_CASE("Mouse move notification of 200 listeners") {
+	auto sum = 0.f;
+	auto const listener = [&sum](avo::math::Point<float> const point) {
+		sum += point.x + point.y;
+	};
+
+	auto std_function_listeners = StdFunctionListeners<avo::math::Point<float>>{};
+	auto listeners = avo::EventListeners<void(avo::math::Point<float>)>{};
+	for ([[maybe_unused]] auto const i : avo::utils::Range{200}) {
+		std_function_listeners.add(listener);
+		listeners += listener;
+	}
+
+	BENCHMARK("std::function and a recursive mutex") {
+		std_function_listeners.notify_all({1.f, 2.f});
+		return sum;
+	};
+	BENCHMARK("avo::EventListeners") {
+		listeners({1.f, 2.f});
+		return sum;
+	};
+}
+
+TEST_CASE("Adding 200 listeners") {
+	auto sum = 0;
+	auto const listener = [&sum](int const value) { sum += value; };
+
+	BENCHMARK("std::function and a recursive mutex") {
+		auto listeners = StdFunctionListeners<int>{};
+		for ([[maybe_unused]] auto const i : avo::utils::Range{200}) {
+			listeners.add(listener);
+		}
+		return listeners.size();
+	};
+	BENCHMARK("avo::EventListeners") {
+		auto listeners = avo::EventListeners<void(int)>{};
+		for ([[maybe_unused]] auto const i : avo::utils::Range{200}) {
+			listeners.add(listener);
+		}
+		return listeners.size();
+	};
+}
@@ -0,0 +1,44 @@
+#include "benchmarking_header.hpp"
+
+#include <filesystem>
+
+namespace {
+
+void benchmark_file_loading(std::size_t const size) {
+	auto const path = (std::filesystem::temp_directory_path() / "avogui_file_loading_benchmark").string();
+	avo::utils::write_to_file(avo::utils::DataVector(size, std::byte{1}), path);
+
+	// Reads one byte per page, which is what it costs to get every page into memory.
+	auto const touch_pages = [](avo::utils::DataView const data) {
+		auto sum = std::size_t{};
+		for (auto position = std::size_t{}; position < data.size(); position += 4096) {
+			sum += static_cast<std::size_t>(data[position]);
+		}
+		return sum;
+	};
+
+	BENCHMARK("avo::utils::read_file") {
+		return touch_pages(avo::utils::read_file(path));
+	};
+	BENCHMARK("avo::utils::MappedFile") {
+		return touch_pages(avo::utils::MappedFile{path}.data());
+	};
+	BENCHMARK("avo::utils::MappedFile, sequential") {
+		return touch_pages(avo::utils::MappedFile{path, avo::utils::FileAccessPattern::Sequential}.data());
+	};
+	BENCHMARK("avo::utils::MappedFile, without reading") {
+		return avo::utils::MappedFile{path}.size();
+	};
+
+	std::filesystem::remove(path);
+}
+
+} // namespace
+
+TEST_CASE("Loading a 1 MB file") {
+	benchmark_file_loading(1 << 20);
+}
+
+TEST_CASE("Loading a 100 MB file") {
+	benchmark_file_loading(100 << 20);
+}
@@ -0,0 +1,131 @@
+#include "benchmarking_header.hpp"
+
+namespace {
+
+struct TreeNode {
+	std::vector<TreeNode> children;
+	TreeNode* parent;
+	int value;
+
+	auto begin() const {
+		return children.begin();
+	}
+	auto begin() {
+		return children.begin();
+	}
+	auto end() const {
+		return children.end();
+	}
+	auto end() {
+		return children.end();
+	}
+};
+
+struct TreeNodeWithoutParent {
+	std::vector<TreeNodeWithoutParent> children;
+	int value;
+
+	auto begin() const {
+		return children.begin();
+	}
+	auto begin() {
+		return children.begin();
+	}
+	auto end() const {
+		return children.end();
+	}
+	auto end() {
+		return children.end();
+	}
+};
+
+template<typename _Node>
+void set_parents(_Node& node) {
+	if constexpr (requires { node.parent; }) {
+		for (auto& child : node.children) {
+			child.parent = &node;
+			set_parents(child);
+		}
+	}
+}
+
+/*
+	A root with width children that each have a single child.
+*/
+template<typename _Node>
+_Node make_wide_tree(int const width) {
+	auto root = _Node{};
+	root.children.resize(static_cast<std::size_t>(width));
+	for (auto const i : avo::utils::indices(root.children)) {
+		root.children[i].value = static_cast<int>(i);
+		root.children[i].children.resize(1);
+	}
+	set_parents(root);
+	return root;
+}
+
+/*
+	A chain of nodes where every node also has a leaf child.
+*/
+template<typename _Node>
+std::unique_ptr<_Node> make_deep_tree(int const depth) {
+	auto root = std::make_unique<_Node>();
+	auto* node = root.get();
+	for (auto const i : avo::utils::Range{depth}) {
+		node->children.resize(2);
+		node->children[0].value = i;
+		node = &node->children[1];
+	}
+	set_parents(*root);
+	return root;
+}
+
+template<typename _Node>
+int sum_of_values(_Node const& tree) {
+	auto sum = 0;
+	for (auto const& node : tree | avo::utils::flatten) {
+		sum += node.value;
+	}
+	return sum;
+}
+
+} // namespace
+
+TEST_CASE("Flattening a wide tree of 200000 nodes") {
+	auto const tree = make_wide_tree<TreeNode>(100000);
+	auto const tree_without_parent = make_wide_tree<TreeNodeWithoutParent>(100000);
+
+	BENCHMARK("Parent links") {
+		return sum_of_values(tree);
+	};
+	BENCHMARK("Parent stack") {
+		return sum_of_values(tree_without_parent);
+	};
+}
+
+TEST_CASE("Flattening a deep tree of 2000 nodes") {
+	// Destroying a tree this deep recurses once per level.
+	auto const tree = make_deep_tree<TreeNode>(1000);
+	auto const tree_without_parent = make_deep_tree<TreeNodeWithoutParent>(1000);
+
+	BENCHMARK("Parent links") {
+		return sum_of_values(*tree);
+	};
+	BENCHMARK("Parent stack") {
+		return sum_of_values(*tree_without_parent);
+	};
+}
+
+TEST_CASE("Creating flattened iterators") {
+	auto const tree = make_wide_tree<TreeNodeWithoutParent>(10);
+
+	BENCHMARK("Parent stack") {
+		auto count = 0;
+		for ([[maybe_unused]] auto const i : avo::utils::Range{1000}) {
+			auto iterator = avo::utils::flatten(tree).begin();
+			++iterator;
+			count += (*iterator++).value;
+		}
+		return count;
+	};
+}
@@ -0,0 +1,65 @@
+#include "benchmarking_header.hpp"
+
+#include <deque>
+
+/*
+	Each of these should compile to the same vectorized loop as the hand-written one.
+*/
+TEST_CASE("Index loops over 100000 integers") {
+	auto values = std::vector<std::uint32_t>(100000);
+	std::iota(values.begin(), values.end(), std::uint32_t{});
+
+	BENCHMARK("Hand-written loop") {
+		auto sum = std::uint32_t{};
+		for (auto i = std::size_t{}; i < values.size(); ++i) {
+			sum += values[i]*static_cast<std::uint32_t>(i);
+		}
+		return sum;
+	};
+	BENCHMARK("avo::utils::Range") {
+		auto sum = std::uint32_t{};
+		for (auto const i : avo::utils::Range{values.size()}) {
+			sum += values[i]*static_cast<std::uint32_t>(i);
+		}
+		return sum;
+	};
+	BENCHMARK("avo::utils::indices") {
+		auto sum = std::uint32_t{};
+		for (auto const i : avo::utils::indices(values)) {
+			sum += values[i]*static_cast<std::uint32_t>(i);
+		}
+		return sum;
+	};
+	BENCHMARK("avo::utils::enumerate") {
+		auto sum = std::uint32_t{};
+		for (auto const [i, value] : avo::utils::enumerate(values)) {
+			sum += value*static_cast<std::uint32_t>(i);
+		}
+		return sum;
+	};
+	BENCHMARK("avo::utils::enumerate writing") {
+		for (auto const [i, value] : avo::utils::enumerate(values)) {
+			value = static_cast<std::uint32_t>(i)*3;
+		}
+		return values.back();
+	};
+}
+
+TEST_CASE("Enumerating a std::deque of 100000 integers") {
+	auto values = std::deque<std::uint32_t>(100000);
+
+	BENCHMARK("Hand-written loop") {
+		auto sum = std::uint32_t{};
+		for (auto i = std::size_t{}; i < values.size(); ++i) {
+			sum += values[i]*static_cast<std::uint32_t>(i);
+		}
+		return sum;
+	};
+	BENCHMARK("avo::utils::enumerate") {
+		auto sum = std::uint32_t{};
+		for (auto const [i, value] : avo::utils::enumerate(values)) {
+			sum += value*static_cast<std::uint32_t>(i);
+		}
+		return sum;
+	};
+}
@@ -0,0 +1,39 @@
+#include "benchmarking_header.hpp"
+
+TEST_CASE("Pre-order traversal of 100000 nodes") {
+	// The same tree in both representations.
+	auto root = avo::Node{};
+	auto const nodes = benchmarks::build_tree(root, 100000);
+
+	auto arena = avo::NodeArena<std::uint64_t>{};
+	auto const arena_root = arena.create(0);
+	auto handles = std::vector<avo::NodeHandle>{};
+	handles.reserve(100000);
+	for (auto const i : avo::utils::Range{std::size_t{100000}}) {
+		auto const parent_index = benchmarks::tree_parent_index(i);
+		handles.push_back(arena.create(parent_index ? handles[*parent_index] : arena_root, std::uint64_t{i} + 1));
+	}
+
+	BENCHMARK("avo::Node") {
+		auto sum = std::uint64_t{};
+		for (auto const& node : root | avo::utils::flatten) {
+			sum += static_cast<std::uint64_t>(node.id());
+		}
+		return sum;
+	};
+	BENCHMARK("avo::NodeArena") {
+		auto sum = std::uint64_t{};
+		for (auto const handle : arena.pre_order(arena_root)) {
+			sum += arena[handle];
+		}
+		return sum;
+	};
+
+	// The last 1000 nodes are leaves, so moving them can never create a cycle.
+	BENCHMARK("avo::NodeArena 1000 reparents") {
+		for (auto const i : avo::utils::Range{1000}) {
+			arena.reparent(handles[99000 + static_cast<std::size_t>(i)], handles[static_cast<std::size_t>(i)]);
+		}
+		return arena.size();
+	};
+}
@@ -0,0 +1,43 @@
+#include "benchmarking_header.hpp"
+
+namespace {
+
+constexpr auto node_count = 30000;
+
+std::vector<avo::Node> make_unattached_nodes() {
+	auto nodes = std::vector<avo::Node>(node_count);
+	for (auto const i : avo::utils::indices(nodes)) {
+		nodes[i].id(avo::Id{static_cast<std::uint64_t>(i) + 1});
+	}
+	return nodes;
+}
+
+} // namespace
+
+TEST_CASE("Attaching 30000 children") {
+	BENCHMARK("Only creating") {
+		return make_unattached_nodes().size();
+	};
+	BENCHMARK("One at a time") {
+		auto root = avo::Node{};
+		auto nodes = make_unattached_nodes();
+		for (auto& node : nodes) {
+			node.parent(root);
+		}
+		return root.size();
+	};
+	BENCHMARK("attach_children") {
+		auto root = avo::Node{};
+		auto nodes = make_unattached_nodes();
+		root.attach_children(nodes);
+		return root.size();
+	};
+	BENCHMARK("attach_children and reparent_all") {
+		auto root = avo::Node{};
+		auto other_root = avo::Node{};
+		auto nodes = make_unattached_nodes();
+		root.attach_children(nodes);
+		avo::reparent_all(root, other_root);
+		return other_root.size();
+	};
+}
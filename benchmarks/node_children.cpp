@@ -0,0 +1,54 @@
+#include "benchmarking_header.hpp"
+
+namespace {
+
+std::vector<std::unique_ptr<avo::Node>> make_children(avo::Node& parent, int const count) {
+	auto children = std::vector<std::unique_ptr<avo::Node>>{};
+	children.reserve(static_cast<std::size_t>(count));
+	for ([[maybe_unused]] auto const i : avo::utils::Range{count}) {
+		children.push_back(std::make_unique<avo::Node>(parent, avo::Id{}));
+	}
+	return children;
+}
+
+} // namespace
+
+TEST_CASE("Creating and detaching 10000 children") {
+	BENCHMARK("Only creating") {
+		auto parent = avo::Node{};
+		return make_children(parent, 10000).size();
+	};
+	BENCHMARK("In creation order") {
+		auto parent = avo::Node{};
+		auto const children = make_children(parent, 10000);
+		for (auto const& child : children) {
+			child->detach();
+		}
+		return parent.size();
+	};
+	BENCHMARK("In reverse order, keeping the order") {
+		auto parent = avo::Node{};
+		parent.keep_child_order(true);
+		auto const children = make_children(parent, 10000);
+		for (auto const& child : children | std::views::reverse) {
+			child->detach();
+		}
+		return parent.size();
+	};
+}
+
+TEST_CASE("Flattening a node with 10000 children") {
+	auto parent = avo::Node{};
+	auto const children = make_children(parent, 10000);
+	auto const grandchildren = [&] {
+		auto result = std::vector<std::unique_ptr<avo::Node>>{};
+		for (auto const& child : children) {
+			result.push_back(std::make_unique<avo::Node>(*child, avo::Id{}));
+		}
+		return result;
+	}();
+
+	BENCHMARK("Flatten") {
+		return std::ranges::distance(parent | avo::utils::flatten);
+	};
+}
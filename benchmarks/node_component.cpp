@@ -0,0 +1,71 @@
+#include "benchmarking_header.hpp"
+
+#include <any>
+
+namespace {
+
+struct Component {
+	int value;
+};
+
+/*
+	The way Node used to store its component.
+*/
+struct AnyComponentNode {
+	std::any component;
+
+	template<typename _Component>
+	_Component* get() const {
+		if (component.type() == typeid(_Component*)) {
+			return std::any_cast<_Component*>(component);
+		}
+		return nullptr;
+	}
+};
+
+} // namespace
+
+TEST_CASE("Component access in a tree of 100000 nodes") {
+	constexpr auto node_count = 100000;
+
+	auto components = std::vector<Component>(node_count);
+	auto any_nodes = std::vector<std::unique_ptr<AnyComponentNode>>{};
+	any_nodes.reserve(node_count);
+	for (auto const i : avo::utils::indices(components)) {
+		components[i].value = static_cast<int>(i);
+		any_nodes.push_back(std::make_unique<AnyComponentNode>(&components[i]));
+	}
+
+	auto root = avo::Node{};
+	auto const nodes = benchmarks::build_tree(root, node_count, [&](std::size_t const i) -> Component& {
+		return components[i];
+	});
+
+	BENCHMARK("std::any and typeid") {
+		auto sum = 0;
+		for (auto const& node : any_nodes) {
+			if (auto const* const component = node->get<Component>()) {
+				sum += component->value;
+			}
+		}
+		return sum;
+	};
+	BENCHMARK("avo::Node::component") {
+		auto sum = 0;
+		for (auto const& node : nodes) {
+			if (auto const* const component = node->component<Component>()) {
+				sum += component->value;
+			}
+		}
+		return sum;
+	};
+	BENCHMARK("avo::Node::component in tree order") {
+		auto sum = 0;
+		for (auto const& node : root | avo::utils::flatten) {
+			if (auto const* const component = node.component<Component>()) {
+				sum += component->value;
+			}
+		}
+		return sum;
+	};
+}
@@ -0,0 +1,35 @@
+#include "benchmarking_header.hpp"
+
+TEST_CASE("Node lookup by ID in a tree of 50000 nodes") {
+	auto root = avo::Node{};
+	auto const nodes = benchmarks::build_tree(root, 50000);
+
+	auto engine = std::mt19937{};
+	auto ids = std::vector<avo::Id>(100);
+	std::ranges::generate(ids, [&] { 
+		return avo::Id{std::uniform_int_distribution<std::uint64_t>{1, 50000}(engine)}; 
+	});
+
+	auto const find_all = [&] {
+		auto found_count = 0;
+		for (auto const id : ids) {
+			found_count += avo::find_node_by_id(root, id) != nullptr;
+		}
+		return found_count;
+	};
+
+	BENCHMARK("100 lookups by traversal") {
+		return find_all();
+	};
+	root.enable_id_index();
+	BENCHMARK("100 lookups in the ID index") {
+		return find_all();
+	};
+	BENCHMARK("100 subtree lookups in the ID index") {
+		auto found_count = 0;
+		for (auto const id : ids) {
+			found_count += avo::find_node_by_id(*nodes[0], id) != nullptr;
+		}
+		return found_count;
+	};
+}
@@ -0,0 +1,43 @@
+#include "benchmarking_header.hpp"
+
+namespace {
+
+/*
+	Stands in for the work of measuring a node in a layout pass.
+*/
+float measure(avo::Node const& node) {
+	auto size = static_cast<float>(static_cast<std::uint64_t>(node.id()));
+	for ([[maybe_unused]] auto const i : avo::utils::Range{20}) {
+		size = std::sqrt(size*size + 1.f);
+	}
+	return size;
+}
+
+} // namespace
+
+TEST_CASE("Traversal of a tree of 100000 nodes") {
+	auto root = avo::Node{};
+	auto const nodes = benchmarks::build_tree(root, 100000, [](std::size_t const i) {
+		return avo::Id{static_cast<std::uint64_t>(i % 1000)};
+	});
+
+	auto const has_id = [](avo::Node const& node) { return node.id() == avo::Id{500}; };
+
+	BENCHMARK("find_nodes_by_id") {
+		return std::ranges::distance(avo::find_nodes_by_id(root, avo::Id{500}));
+	};
+	BENCHMARK("utils::find_all_parallel") {
+		return avo::utils::find_all_parallel(root, has_id).size();
+	};
+
+	BENCHMARK("Sequential measure pass") {
+		auto sum = 0.f;
+		for (auto const& node : root | avo::utils::flatten) {
+			sum += measure(node);
+		}
+		return sum;
+	};
+	BENCHMARK("utils::transform_reduce_parallel measure pass") {
+		return avo::utils::transform_reduce_parallel(root, 0.f, std::plus{}, measure);
+	};
+}
@@ -0,0 +1,80 @@
+#include "benchmarking_header.hpp"
+
+#include <unordered_map>
+
+namespace {
+
+template<typename _Map>
+float sum_of_color_lookups(_Map const& colors, std::span<avo::Id const> const ids) {
+	auto sum = 0.f;
+	for (auto const id : ids) {
+		sum += colors.find(id)->second.red;
+	}
+	return sum;
+}
+
+} // namespace
+
+TEST_CASE("Theme color lookup") {
+	auto const theme = avo::Theme{};
+	
+	auto const unordered_colors = std::unordered_map<avo::Id, avo::Color>(theme.colors.begin(), theme.colors.end());
+
+	auto theme_color_ids = std::vector<avo::Id>{};
+	std::ranges::transform(theme.colors, std::back_inserter(theme_color_ids), [](auto const& entry) { 
+		return entry.first; 
+	});
+
+	// Lookups in a random order, like when drawing a lot of different views.
+	auto ids = std::vector<avo::Id>(10000);
+	auto engine = std::mt19937{};
+	std::ranges::generate(ids, [&] { 
+		return theme_color_ids[std::uniform_int_distribution<std::size_t>{0, theme_color_ids.size() - 1}(engine)]; 
+	});
+
+	BENCHMARK("std::unordered_map") {
+		return sum_of_color_lookups(unordered_colors, ids);
+	};
+	BENCHMARK("avo::IdMap") {
+		return sum_of_color_lookups(theme.colors, ids);
+	};
+}
+
+TEST_CASE("Theme entry caches of 20000 consumers") {
+	auto theme = avo::Theme{};
+
+	auto theme_color_ids = std::vector<avo::Id>{};
+	std::ranges::transform(theme.colors, std::back_inserter(theme_color_ids), [](auto const& entry) { 
+		return entry.first; 
+	});
+
+	auto caches = std::vector<avo::ThemeEntryCache<avo::Color>>{};
+	caches.reserve(20000);
+	for (auto const i : avo::utils::Range{20000}) {
+		caches.emplace_back(theme_color_ids[static_cast<std::size_t>(i) % theme_color_ids.size()]);
+	}
+
+	auto const resolve_all = [&] {
+		auto sum = 0.f;
+		for (auto& cache : caches) {
+			sum += cache.get(theme).red;
+		}
+		return sum;
+	};
+	
+	BENCHMARK("Lookup in the theme") {
+		auto sum = 0.f;
+		for (auto const& cache : caches) {
+			sum += theme.colors.at(cache.id()).red;
+		}
+		return sum;
+	};
+	BENCHMARK("Unchanged theme") {
+		return resolve_all();
+	};
+	BENCHMARK("One changed color per frame") {
+		theme.color(avo::theme_colors::primary, avo::Color{static_cast<float>(theme.version() % 2)});
+		static_cast<void>(theme.take_changes());
+		return resolve_all();
+	};
+}
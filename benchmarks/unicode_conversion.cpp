@@ -0,0 +1,93 @@
+#include "benchmarking_header.hpp"
+
+#ifndef _WIN32
+#	include <iconv.h>
+#endif
+
+namespace {
+
+constexpr auto text_sample = "Hello AvoGUI! مجفف شعر أم مكنسة كهربائية؟ 🪢 här √ är knut. "sv;
+
+[[nodiscard]]
+std::string make_utf8_input(std::size_t const size) {
+	auto result = std::string{};
+	result.reserve(size + text_sample.size());
+	while (result.size() < size) {
+		result += text_sample;
+	}
+	// Don't cut a character in half.
+	auto end = size;
+	while (!avo::unicode::is_first_code_point(result[end])) {
+		--end;
+	}
+	result.resize(end);
+	return result;
+}
+
+#ifndef _WIN32
+/*
+	The conversion path used before the native transcoder and cached converters; 
+	one iconv descriptor is opened and closed for every conversion.
+*/
+std::size_t utf8_to_utf16_uncached(std::string_view const input, std::span<char16_t> const output) {
+	auto const converter = iconv_open("UTF-16LE", "UTF-8");
+	auto in_pointer = const_cast<char*>(input.data());
+	auto in_bytes_left = input.size();
+	auto out_pointer = reinterpret_cast<char*>(output.data());
+	auto out_bytes_left = output.size()*sizeof(char16_t);
+	iconv(converter, &in_pointer, &in_bytes_left, &out_pointer, &out_bytes_left);
+	iconv_close(converter);
+	return output.size() - out_bytes_left/sizeof(char16_t);
+}
+std::size_t utf16_to_utf8_uncached(std::u16string_view const input, std::span<char> const output) {
+	auto const converter = iconv_open("UTF-8", "UTF-16");
+	auto in_pointer = const_cast<char*>(reinterpret_cast<char const*>(input.data()));
+	auto in_bytes_left = input.size()*sizeof(char16_t);
+	auto out_pointer = output.data();
+	auto out_bytes_left = output.size();
+	iconv(converter, &in_pointer, &in_bytes_left, &out_pointer, &out_bytes_left);
+	iconv_close(converter);
+	return output.size() - out_bytes_left;
+}
+#endif
+
+void benchmark_conversion(std::size_t const input_size) {
+	auto const utf8_input = make_utf8_input(input_size);
+	auto const utf16_input = avo::unicode::utf8_to_utf16(utf8_input);
+
+	auto utf16_output = std::u16string(utf8_input.size(), u'\0');
+	auto utf8_output = std::string(utf16_input.size()*3, '\0');
+
+	BENCHMARK("UTF-8 to UTF-16") {
+		return avo::unicode::utf8_to_utf16(utf8_input, utf16_output);
+	};
+	BENCHMARK("UTF-16 to UTF-8") {
+		return avo::unicode::utf16_to_utf8(utf16_input, utf8_output);
+	};
+	BENCHMARK("UTF-8 to UTF-16, allocating") {
+		return avo::unicode::utf8_to_utf16(utf8_input);
+	};
+	BENCHMARK("UTF-16 to UTF-8, allocating") {
+		return avo::unicode::utf16_to_utf8(utf16_input);
+	};
+#ifndef _WIN32
+	BENCHMARK("UTF-8 to UTF-16, iconv_open per call") {
+		return utf8_to_utf16_uncached(utf8_input, utf16_output);
+	};
+	BENCHMARK("UTF-16 to UTF-8, iconv_open per call") {
+		return utf16_to_utf8_uncached(utf16_input, utf8_output);
+	};
+#endif
+}
+
+} // namespace
+
+TEST_CASE("Unicode conversion of 16 B") {
+	benchmark_conversion(16);
+}
+TEST_CASE("Unicode conversion of 1 KiB") {
+	benchmark_conversion(1 << 10);
+}
+TEST_CASE("Unicode conversion of 1 MiB") {
+	benchmark_conversion(1 << 20);
+}
@@ -0,0 +1,80 @@
+#include "benchmarking_header.hpp"
+
+#include <cstdlib>
+
+#ifndef _WIN32
+#	include <X11/Xlib.h>
+#endif
+
+/*
+	These need a display, for example Xvfb, and are skipped without one.
+*/
+TEST_CASE("Changing a window 3 times per frame") {
+#ifndef _WIN32
+	if (!std::getenv("DISPLAY")) {
+		WARN("Skipped because there is no display.");
+		return;
+	}
+#endif
+	using namespace avo::math;
+
+	auto window = avo::window("Benchmark")
+		.position(Vector2d{0.5f, 0.5f})
+		.size(Size{500.f, 400.f})
+		.open();
+
+	BENCHMARK("Batched") {
+		window.title("Benchmark");
+		window.size(Size{300.f, 300.f});
+		window.position(Point{300, 200});
+	};
+	BENCHMARK("Flushing after every change") {
+		window.title("Benchmark");
+		window.flush();
+		window.size(Size{300.f, 300.f});
+		window.flush();
+		window.position(Point{300, 200});
+		window.flush();
+	};
+}
+
+#ifndef _WIN32
+TEST_CASE("X protocol requests of a typical startup") {
+	if (!std::getenv("DISPLAY")) {
+		WARN("Skipped because there is no display.");
+		return;
+	}
+	using namespace avo::math;
+
+	auto window = avo::window("Benchmark")
+		.position(Vector2d{0.5f, 0.5f})
+		.size(Size{500.f, 400.f})
+		.open();
+	window.flush();
+
+	/*
+		The sequence number of the next request grows by one for every request that is made 
+		on the connection, including those made by the event thread.
+	*/
+	auto* const display = std::any_cast<::Display*>(window.native_display());
+	auto const count_requests = [display](auto const& action) {
+		auto const first_request = ::XNextRequest(display);
+		action();
+		return ::XNextRequest(display) - first_request;
+	};
+
+	auto const change_requests = count_requests([&] {
+		window.title("Startup");
+		window.size(Size{300.f, 300.f});
+		window.position(Point{300, 200});
+		window.flush();
+	});
+	WARN("Requests for renaming, resizing and moving a window: " << change_requests);
+
+	auto const open_requests = count_requests([] {
+		auto other_window = avo::window("Other window").size(Size{200.f, 200.f}).open();
+		other_window.flush();
+	});
+	WARN("Requests for opening and closing another window on the shared connection: " << open_requests);
+}
+#endif
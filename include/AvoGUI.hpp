@@ -27,12 +27,15 @@ SOFTWARE.
 #include <algorithm>
 #include <any>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <charconv>
 #include <chrono>
 #include <cmath>
 #include <concepts>
 #include <cstdint>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <functional>
 #include <iomanip>
@@ -45,11 +48,12 @@ SOFTWARE.
 #include <random>
 #include <ranges>
 #include <span>
-#include <stack>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <thread>
 #include <tuple>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -215,6 +219,14 @@ public:
 
 		[[nodiscard]]
 		constexpr auto operator<=>(Iterator const& other) const noexcept = default;
+		/*
+			Written out because GCC does not vectorize loops that compare 
+			with the operator== implied by the defaulted operator<=>.
+		*/
+		[[nodiscard]]
+		constexpr bool operator==(Iterator const& other) const noexcept {
+			return _current_value == other._current_value;
+		}
 
 		constexpr Iterator() noexcept = default;
 		constexpr Iterator(_Value const value) noexcept :
@@ -240,7 +252,10 @@ public:
 		return _end;
 	}
 
-	constexpr bool operator==(Range const&) const noexcept = default;
+	[[nodiscard]]
+	constexpr bool operator==(Range const& other) const noexcept {
+		return _start == other._start && _end == other._end;
+	}
 
 	/*
 		Creates a range of integers starting with start and ending with inclusive_end.
@@ -412,13 +427,30 @@ struct EnumeratedElement final {
 /*
 	Takes any range and returns a new range of (index, element) pairs referring to the original range.
 	The original range isn't moved anywhere.
+	Random access ranges are enumerated by looking up the element at each index, which 
+	gives a random access view that compiles to the same loop as indexing by hand.
+	Other ranges count the index while iterating, so they can only be iterated once.
 */
 [[nodiscard]]
 constexpr std::ranges::view auto enumerate(std::ranges::range auto& range) 
 {
-	return range | std::views::transform([i = std::size_t{}](auto& element) mutable {
-		return EnumeratedElement{i++, element};
-	});
+	if constexpr (std::ranges::contiguous_range<decltype(range)> && std::ranges::sized_range<decltype(range)>) {
+		return std::views::iota(std::size_t{}, static_cast<std::size_t>(std::ranges::size(range))) 
+			| std::views::transform([data = std::ranges::data(range)](std::size_t const index) {
+				return EnumeratedElement{index, data[index]};
+			});
+	}
+	else if constexpr (std::ranges::random_access_range<decltype(range)> && std::ranges::sized_range<decltype(range)>) {
+		return std::views::iota(std::size_t{}, static_cast<std::size_t>(std::ranges::size(range))) 
+			| std::views::transform([begin = std::ranges::begin(range)](std::size_t const index) {
+				return EnumeratedElement{index, begin[static_cast<std::ptrdiff_t>(index)]};
+			});
+	}
+	else {
+		return range | std::views::transform([i = std::size_t{}](auto& element) mutable {
+			return EnumeratedElement{i++, element};
+		});
+	}
 }
 
 /*
@@ -515,6 +547,23 @@ static_assert(
 	}(),
 	"avo::utils::enumerate with lvalue reference failed."
 );
+static_assert(
+	[] {
+		auto container = std::array{3, 1, 4};
+		auto const enumerated = enumerate(container);
+		for ([[maybe_unused]] auto const pass : Range{2}) {
+			auto correct_index = std::size_t{};
+			for (auto const [index, element] : enumerated) {
+				element *= 2;
+				if (index != correct_index++) {
+					return false;
+				}
+			}
+		}
+		return container == std::array{12, 4, 16} && enumerated[2].index == 2;
+	}(),
+	"avo::utils::enumerate of a contiguous range can not be iterated more than once."
+);
 static_assert(
 	[] {
 		constexpr auto original_container = std::array{3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 6};
@@ -533,6 +582,71 @@ static_assert(
 
 //------------------------------
 
+/*
+	A stack that stores its first inline_capacity elements inside of the object itself, 
+	and only allocates memory when it grows beyond that.
+*/
+template<std::semiregular T, std::size_t inline_capacity>
+class SmallStack final {
+public:
+	using value_type = T;
+
+	constexpr void push(T value) {
+		if (_size < inline_capacity) {
+			_inline_elements[_size] = std::move(value);
+		}
+		else {
+			_overflow_elements.push_back(std::move(value));
+		}
+		++_size;
+	}
+	constexpr void pop() noexcept {
+		if (--_size >= inline_capacity) {
+			_overflow_elements.pop_back();
+		}
+	}
+
+	[[nodiscard]]
+	constexpr T& top() noexcept {
+		return _size > inline_capacity ? _overflow_elements.back() : _inline_elements[_size - 1];
+	}
+	[[nodiscard]]
+	constexpr T const& top() const noexcept {
+		return _size > inline_capacity ? _overflow_elements.back() : _inline_elements[_size - 1];
+	}
+
+	[[nodiscard]]
+	constexpr std::size_t size() const noexcept {
+		return _size;
+	}
+	[[nodiscard]]
+	constexpr bool empty() const noexcept {
+		return _size == 0;
+	}
+
+private:
+	std::array<T, inline_capacity> _inline_elements{};
+	std::vector<T> _overflow_elements;
+	std::size_t _size{};
+};
+
+#ifdef BUILD_TESTING
+static_assert([]{
+	auto stack = SmallStack<int, 2>{};
+	for (auto const i : Range{5}) {
+		stack.push(i);
+	}
+	auto is_correct = stack.size() == 5;
+	for (auto const i : Range<int, true>{4, 0}) {
+		is_correct = is_correct && stack.top() == i;
+		stack.pop();
+	}
+	return is_correct && stack.empty();
+}());
+#endif // BUILD_TESTING
+
+//------------------------------
+
 /*
 	Evaluates to whether the type T is a range whose value type is the same as the base range.
 
@@ -633,7 +747,8 @@ public:
 		
 		std::variant<T*, BaseIterator> _current_position;
 		BaseIterator _end;
-		std::stack<BaseIterator> _parent_stack;
+		// Trees are rarely deeper than this, so iterating normally does not allocate.
+		SmallStack<BaseIterator, 16> _parent_stack;
 	};
 
 	[[nodiscard]]
@@ -729,7 +844,18 @@ public:
 	
 		static BaseIterator get_iterator_of_node(T& node) {
 			auto* const parent = get_parent_of_node(node);
-			return std::begin(*parent) + (&node - &*std::begin(*parent));
+			if constexpr (std::ranges::contiguous_range<T>) {
+				return std::begin(*parent) + (&node - &*std::begin(*parent));
+			}
+			else if constexpr (std::ranges::random_access_range<T> && 
+				requires { { node.index_in_parent() } -> std::same_as<std::size_t>; }) 
+			{
+				return std::begin(*parent) + static_cast<std::ptrdiff_t>(node.index_in_parent());
+			}
+			else {
+				// The children are not stored next to each other, so their addresses can't be used to find their positions.
+				return std::ranges::find_if(*parent, [&](auto const& child) { return &child == &node; });
+			}
 		}
 	
 		void _increment_iterator() {
@@ -954,8 +1080,10 @@ public:
 		handle._handle = invalid_handle;
 	}
 	UniqueHandle& operator=(UniqueHandle&& handle) noexcept {
-		_handle = handle._handle;
-		handle._handle = invalid_handle;
+		if (this != std::addressof(handle)) {
+			close();
+			_handle = std::exchange(handle._handle, invalid_handle);
+		}
 		return *this;
 	}
 
@@ -984,6 +1112,67 @@ inline DataVector read_file(std::string const path) {
 	return result;
 }
 
+/*
+	How the contents of a mapped file are going to be read, which lets the 
+	operating system choose how much to read ahead.
+*/
+enum class FileAccessPattern {
+	Normal,
+	Sequential,
+	Random,
+};
+
+/*
+	A read-only file whose contents are mapped into memory instead of being copied, 
+	so pages are only read from disk when they are first accessed.
+	If the file can't be mapped, for example on platforms without memory mapping 
+	support, its contents are read with read_file instead.
+	The data is empty if the file could not be opened.
+*/
+class MappedFile final {
+public:
+	[[nodiscard]]
+	DataView data() const noexcept {
+		if (_mapping) {
+			return {_mapping->address, _mapping->size};
+		}
+		return _fallback_data;
+	}
+	[[nodiscard]]
+	std::size_t size() const noexcept {
+		return data().size();
+	}
+	[[nodiscard]]
+	bool empty() const noexcept {
+		return data().empty();
+	}
+
+	/*
+		Returns whether the data is mapped from the file rather than read into memory.
+	*/
+	[[nodiscard]]
+	bool is_memory_mapped() const noexcept {
+		return static_cast<bool>(_mapping);
+	}
+
+	explicit MappedFile(std::string const& path, FileAccessPattern access_pattern = FileAccessPattern::Normal);
+	MappedFile() = default;
+
+private:
+	struct _Mapping {
+		std::byte const* address;
+		std::size_t size;
+
+		bool operator==(_Mapping const&) const = default;
+	};
+	struct _Unmap {
+		void operator()(_Mapping mapping) const noexcept;
+	};
+
+	UniqueHandle<_Mapping, _Unmap> _mapping;
+	DataVector _fallback_data;
+};
+
 template<std::ranges::contiguous_range _DataRange> requires IsByte<std::ranges::range_value_t<_DataRange>>
 void write_to_file(_DataRange const& data, std::string const& file_name) {
 	// std::string because std::ofstream does not take std::string_view.
@@ -1050,161 +1239,984 @@ static_assert(
 );
 #endif // BUILD_TESTING
 
-} // namespace utils
-
 //------------------------------
 
 /*
-	Unicode support library.
+	Identifies a type without using RTTI.
+	The tag of a type is the address of a variable that only exists for that type.
 */
-namespace unicode {
+using TypeTag = void const*;
 
-/*
-	Enables UTF-8 encoded console output on Windows.
-	Pretty much all other platforms use UTF-8 by default.
-*/
-void enable_utf8_console();
+template<typename T>
+inline constexpr char _type_tag_object{};
 
-//------------------------------
+template<typename T>
+inline constexpr TypeTag type_tag = &_type_tag_object<T>;
 
 /*
-	Converts a UTF-8 encoded char string to a UTF-16 encoded char16 string.
-	Returns the length of the converted string, in code point units (char16_t).
-	If no value is returned then the output span is too small to fit the whole converted string.
-*/
-std::optional<std::size_t> utf8_to_utf16(std::string_view input, std::span<char16_t> output);
-/*
-	Converts a UTF-8 encoded string to a UTF-16 encoded std::u16string.
+	Returns the signature of this function, which contains the name of T.
 */
+template<typename T>
 [[nodiscard]]
-std::u16string utf8_to_utf16(std::string_view input);
+constexpr std::string_view type_signature() noexcept {
+#ifdef _MSC_VER
+	return __FUNCSIG__;
+#else
+	return __PRETTY_FUNCTION__;
+#endif
+}
 
 /*
-	Converts a UTF-16 encoded char16 string to a UTF-8 encoded char string.
-	Returns the length of the converted string, in code point units (char).
-	If no value is returned then the output span is too small to fit the whole converted string.
-*/
-std::optional<std::size_t> utf16_to_utf8(std::u16string_view input, std::span<char> output);
-/*
-	Converts a UTF-16 char16 string to a UTF-8 encoded std::string.
+	Identifies a type without using RTTI, like TypeTag, but in 32 bits.
+	The ID is a hash of type_signature<T>() computed at compile time, so it is the same in 
+	every part of a program, including shared libraries. 0 is not the ID of any type.
+	Two types could get the same ID, see check_type_id.
 */
-[[nodiscard]]
-std::string utf16_to_utf8(std::u16string_view input);
+using TypeId = std::uint32_t;
 
-//------------------------------
+template<typename T>
+inline constexpr TypeId type_id = [] {
+	// 32 bit FNV-1a
+	auto hash = TypeId{0x811c9dc5};
+	for (auto const character : type_signature<T>()) {
+		hash = (hash ^ static_cast<unsigned char>(character)) * TypeId{0x01000193};
+	}
+	return hash ? hash : TypeId{1};
+}();
 
 /*
-	Returns the number of UTF-8 code points a character starting with 
-	first_code_point_in_character consists of in total.
-	Returns 0 if the code point is not the first one in a character.
-	Returns -1 if the code point is an invalid UTF-8 code point.
+	Throws std::logic_error if a different type that has been checked before has the same TypeId as T.
+	This is only done in debug builds and only the first time a type is checked, 
+	and does nothing in release builds.
 */
-[[nodiscard]]
-constexpr int code_point_count(char const first_code_point_in_character) noexcept {
-	// http://www.unicode.org/versions/Unicode12.1.0/ch03.pdf , page 126
-	if (!(first_code_point_in_character & 0x80)) // 0xxxxxxx
-		return 1;
-	if ((first_code_point_in_character & 0xc0) == 0x80) // 10??????
-		return 0;
-	if ((first_code_point_in_character & 0xe0) == 0xc0) // 110yyyyy
-		return 2;
-	if ((first_code_point_in_character & 0xf0) == 0xe0) // 1110zzzz
-		return 3;
-	if ((first_code_point_in_character & 0xf8) == 0xf0) // 11110uuu
-		return 4;
-	return -1;
+template<typename T>
+void check_type_id() {
+#ifndef NDEBUG
+	[[maybe_unused]] static bool const is_checked = [] {
+		static auto mutex = std::mutex{};
+		static auto checked_types = std::vector<std::pair<TypeId, std::string_view>>{};
+
+		auto const lock = std::scoped_lock{mutex};
+		for (auto const& [id, signature] : checked_types) {
+			if (id == type_id<T> && signature != type_signature<T>()) {
+				throw std::logic_error{"Two types have the same avo::utils::TypeId."};
+			}
+		}
+		checked_types.emplace_back(type_id<T>, type_signature<T>());
+		return true;
+	}();
+#endif
 }
 
-/*
-	Returns the number of UTF-16 code points a character starting with 
-	first_code_point_in_character consists of in total.
-	Returns 0 if the code point is not the first one in a character.
-	Returns -1 if the code point is an invalid UTF-16 code point.
-*/
-[[nodiscard]]
-constexpr int code_point_count(char16_t const first_code_point_in_character) noexcept {
-	// http://www.unicode.org/versions/Unicode12.1.0/ch03.pdf , page 125
-	if ((first_code_point_in_character & 0xfc00) == 0xd800) // 110110wwwwxxxxxx
-		return 2;
-	if ((first_code_point_in_character & 0xfc00) == 0xdc00) // 110111xxxxxxxxxx
-		return 0;
-	return 1; // xxxxxxxxxxxxxxxx
-}
+//------------------------------
 
-/*
-	Returns whether the passed code point is the start of a UTF-8 encoded character.
-*/
-[[nodiscard]]
-constexpr bool is_first_code_point(char const code_point) noexcept {
-	return (code_point & 0xc0) != 0x80;
-}
+template<typename T, std::size_t capacity = 4*sizeof(void*)>
+class InplaceFunction;
 
 /*
-	Returns whether p_unit is the start of a UTF-16 encoded character
+	A copyable type-erased callable like std::function, except that callables which are at most 
+	capacity bytes large are stored inside of the object itself instead of on the heap.
+	The default capacity fits a lambda capturing four references.
+	Larger callables and callables that can throw when moved are still supported but are heap allocated.
 */
-[[nodiscard]]
-constexpr bool is_first_code_point(char16_t const code_point) noexcept {
-	return (code_point & 0xfc00) != 0xdc00;
-}
+template<typename _Return, typename ... _Arguments, std::size_t capacity>
+class InplaceFunction<_Return(_Arguments...), capacity> final {
+	template<typename _Callable>
+	static constexpr bool is_stored_inline = sizeof(_Callable) <= capacity && 
+		alignof(_Callable) <= alignof(std::max_align_t) && 
+		std::is_nothrow_move_constructible_v<_Callable>;
 
-template<typename T>
-concept IsCodePoint = utils::IsAnyOf<T, char, char16_t>;
+public:
+	/*
+		Returns whether the callable is stored inside of the InplaceFunction without any allocation.
+	*/
+	template<typename _Callable>
+	[[nodiscard]]
+	static constexpr bool stores_inline() noexcept {
+		return is_stored_inline<std::decay_t<_Callable>>;
+	}
 
-/*
-	Returns the index of the code point at a certain character index in a UTF-8 or UTF-16 encoded string.
-	If character_index is outside of the string, the size of the string is returned.
-*/
-template<IsCodePoint T>
-[[nodiscard]]
-constexpr std::size_t code_point_index(std::basic_string_view<T> const string, std::size_t const character_index) 
-{
-	if (!character_index) {
-		return {};
+	_Return operator()(_Arguments ... arguments) const {
+		return _operations->invoke(_storage, std::forward<_Arguments>(arguments)...);
 	}
-	if (character_index >= string.size()) {
-		return string.size();
+
+	[[nodiscard]]
+	explicit operator bool() const noexcept {
+		return _operations;
 	}
 
-	auto const position = std::ranges::find_if(
-		string, [character_index, char_count = std::size_t{}](T const code_point) mutable {
-			return is_first_code_point(code_point) && char_count++ == character_index;
-		}
-	);
-	return position - string.begin();
-}
+	/*
+		Returns the tag of the type of the stored callable, or nullptr if the InplaceFunction is empty.
+	*/
+	[[nodiscard]]
+	TypeTag target_type() const noexcept {
+		return _operations ? _operations->type : nullptr;
+	}
+	/*
+		Returns a pointer to the stored callable if it is of type T, otherwise nullptr.
+	*/
+	template<typename T>
+	[[nodiscard]]
+	T* target() noexcept {
+		return target_type() == type_tag<T> ? static_cast<T*>(_operations->target(_storage)) : nullptr;
+	}
+	template<typename T>
+	[[nodiscard]]
+	T const* target() const noexcept {
+		return target_type() == type_tag<T> ? static_cast<T const*>(_operations->target(_storage)) : nullptr;
+	}
 
-/*
-	Returns the index of the character that the code point at code_point_index in the UTF-8 or UTF-16 encoded string belongs to.
-	If code_point_index is outside of the string, the last character index is returned.
-	If code_point_index is past the start of a character but before the next one, it returns the index of the character it is part of.
-*/
-template<IsCodePoint T>
-[[nodiscard]]
-constexpr std::size_t character_index(std::basic_string_view<T> const string, std::size_t const code_point_index) 
-{
-	if (!code_point_index) {
-		return {};
+	template<typename _Callable> requires 
+		(!std::same_as<std::remove_cvref_t<_Callable>, InplaceFunction>) &&
+		std::copy_constructible<std::decay_t<_Callable>> &&
+		std::is_invocable_r_v<_Return, std::decay_t<_Callable>&, _Arguments...>
+	InplaceFunction(_Callable&& callable) :
+		_operations{&_operations_for<std::decay_t<_Callable>>}
+	{
+		using Stored = std::decay_t<_Callable>;
+		if constexpr (is_stored_inline<Stored>) {
+			new (_storage) Stored(std::forward<_Callable>(callable));
+		}
+		else {
+			*reinterpret_cast<Stored**>(_storage) = new Stored(std::forward<_Callable>(callable));
+		}
 	}
-	if (code_point_index >= string.size()) {
-		return string.size();
+
+	InplaceFunction() = default;
+	~InplaceFunction() {
+		_reset();
 	}
 
-	return std::ranges::count_if(
-		string.begin() + 1, string.begin() + code_point_index + 1,
-		[](T const code_point) { return is_first_code_point(code_point); }
-	);
-}
+	InplaceFunction(InplaceFunction const& other) :
+		_operations{other._operations}
+	{
+		if (_operations) {
+			_operations->copy(other._storage, _storage);
+		}
+	}
+	InplaceFunction& operator=(InplaceFunction const& other) {
+		if (this != &other) {
+			*this = InplaceFunction{other};
+		}
+		return *this;
+	}
+	
+	InplaceFunction(InplaceFunction&& other) noexcept :
+		_operations{std::exchange(other._operations, nullptr)}
+	{
+		if (_operations) {
+			_operations->move(other._storage, _storage);
+		}
+	}
+	InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+		if (this != &other) {
+			_reset();
+			_operations = std::exchange(other._operations, nullptr);
+			if (_operations) {
+				_operations->move(other._storage, _storage);
+			}
+		}
+		return *this;
+	}
 
-/*
-	Returns the number of unicode characters that a UTF-8 or UTF-16 string consists of.
-*/
-template<IsCodePoint T>
-[[nodiscard]]
-constexpr std::size_t character_count(std::basic_string_view<T> const string) {
-	return character_index(string, string.size()) + 1;
-}
+private:
+	struct _Operations {
+		_Return (*invoke)(std::byte*, _Arguments&& ...);
+		void (*copy)(std::byte* source, std::byte* destination);
+		// Moves the callable into destination and destroys the callable in source.
+		void (*move)(std::byte* source, std::byte* destination) noexcept;
+		void (*destroy)(std::byte*) noexcept;
+		void* (*target)(std::byte*) noexcept;
+		TypeTag type;
+	};
 
-#ifdef BUILD_TESTING
+	template<typename _Callable>
+	static _Callable& _get(std::byte* const storage) noexcept {
+		if constexpr (is_stored_inline<_Callable>) {
+			return *std::launder(reinterpret_cast<_Callable*>(storage));
+		}
+		else {
+			return **reinterpret_cast<_Callable**>(storage);
+		}
+	}
+
+	template<typename _Callable>
+	static constexpr auto _operations_for = _Operations{
+		.invoke = [](std::byte* const storage, _Arguments&& ... arguments) -> _Return {
+			if constexpr (std::is_void_v<_Return>) {
+				std::invoke(_get<_Callable>(storage), std::forward<_Arguments>(arguments)...);
+			}
+			else {
+				return std::invoke(_get<_Callable>(storage), std::forward<_Arguments>(arguments)...);
+			}
+		},
+		.copy = [](std::byte* const source, std::byte* const destination) {
+			auto const& callable = _get<_Callable>(source);
+			if constexpr (is_stored_inline<_Callable>) {
+				new (destination) _Callable(callable);
+			}
+			else {
+				*reinterpret_cast<_Callable**>(destination) = new _Callable(callable);
+			}
+		},
+		.move = [](std::byte* const source, std::byte* const destination) noexcept {
+			if constexpr (is_stored_inline<_Callable>) {
+				auto& callable = _get<_Callable>(source);
+				new (destination) _Callable(std::move(callable));
+				callable.~_Callable();
+			}
+			else {
+				*reinterpret_cast<_Callable**>(destination) = *reinterpret_cast<_Callable**>(source);
+			}
+		},
+		.destroy = [](std::byte* const storage) noexcept {
+			if constexpr (is_stored_inline<_Callable>) {
+				_get<_Callable>(storage).~_Callable();
+			}
+			else {
+				delete &_get<_Callable>(storage);
+			}
+		},
+		.target = [](std::byte* const storage) noexcept -> void* {
+			return &_get<_Callable>(storage);
+		},
+		.type = type_tag<_Callable>,
+	};
+
+	void _reset() noexcept {
+		if (_operations) {
+			_operations->destroy(_storage);
+			_operations = nullptr;
+		}
+	}
+
+	// Mutable because a const InplaceFunction can invoke a callable with mutable state, just like std::function.
+	alignas(std::max_align_t) mutable std::byte _storage[capacity];
+	_Operations const* _operations{};
+};
+
+#ifdef BUILD_TESTING
+static_assert(InplaceFunction<void()>::stores_inline<void(*)()>());
+static_assert(!InplaceFunction<void(), 8>::stores_inline<std::array<char, 9>>());
+#endif // BUILD_TESTING
+
+//------------------------------
+
+/*
+	A lock-free queue that any number of threads can push elements to, and that one thread consumes elements from.
+	Pushing is a single compare-and-swap on the newest element. The consumer takes all queued 
+	elements at once with a single exchange, which means that consuming never waits for producers.
+*/
+template<typename T>
+class MpscQueue final {
+public:
+	using value_type = T;
+
+	/*
+		Can be called from any thread.
+	*/
+	void push(T value) {
+		auto* const node = new _Node{std::move(value), _newest.load(std::memory_order::relaxed)};
+		while (!_newest.compare_exchange_weak(node->next, node, std::memory_order::release, std::memory_order::relaxed));
+	}
+
+	/*
+		Removes all of the queued elements and calls consume with each one, oldest first.
+		Only one thread at a time may consume elements.
+		Returns the number of consumed elements.
+	*/
+	template<std::invocable<T&> _Consume>
+	std::size_t consume_all(_Consume&& consume) {
+		// The elements are linked from newest to oldest, so they are reversed first.
+		auto* oldest = static_cast<_Node*>(nullptr);
+		for (auto* node = _newest.exchange(nullptr, std::memory_order::acquire); node;) {
+			oldest = std::exchange(node, std::exchange(node->next, oldest));
+		}
+
+		auto count = std::size_t{};
+		auto const cleanup = Cleanup{[&oldest] { _delete_all(oldest); }};
+		while (oldest) {
+			auto const node = std::unique_ptr<_Node>{std::exchange(oldest, oldest->next)};
+			consume(node->value);
+			++count;
+		}
+		return count;
+	}
+	/*
+		Removes all of the queued elements and returns the newest one, or std::nullopt if the queue was empty.
+		Only one thread at a time may consume elements.
+	*/
+	[[nodiscard]]
+	std::optional<T> consume_newest() {
+		auto* const newest = _newest.exchange(nullptr, std::memory_order::acquire);
+		if (!newest) {
+			return std::nullopt;
+		}
+		_delete_all(std::exchange(newest->next, nullptr));
+		auto const node = std::unique_ptr<_Node>{newest};
+		return std::move(node->value);
+	}
+
+	[[nodiscard]]
+	bool empty() const noexcept {
+		return !_newest.load(std::memory_order::relaxed);
+	}
+
+	MpscQueue() = default;
+	~MpscQueue() {
+		_delete_all(_newest.exchange(nullptr));
+	}
+
+	/*
+		Moving a queue is not thread-safe.
+	*/
+	MpscQueue(MpscQueue&& other) noexcept :
+		_newest{other._newest.exchange(nullptr)}
+	{}
+	MpscQueue& operator=(MpscQueue&& other) noexcept {
+		_delete_all(_newest.exchange(other._newest.exchange(nullptr)));
+		return *this;
+	}
+
+	MpscQueue(MpscQueue const&) = delete;
+	MpscQueue& operator=(MpscQueue const&) = delete;
+
+private:
+	struct _Node {
+		T value;
+		_Node* next;
+	};
+
+	static void _delete_all(_Node* node) noexcept {
+		while (node) {
+			delete std::exchange(node, node->next);
+		}
+	}
+
+	std::atomic<_Node*> _newest{};
+};
+
+//------------------------------
+
+/*
+	Holds a value that can be read from any thread without locking, while other threads write to it.
+	A reader copies the value and retries if a write happened during the copy, so reads never block writers.
+	Writers are serialized by spinning, so writes should be short and not very frequent.
+	The value is stored as atomic words, which means that a torn copy is never a data race, 
+	just a copy that gets thrown away.
+*/
+template<typename T> requires std::is_trivially_copyable_v<T> && std::default_initializable<T>
+class SeqLock final {
+public:
+	using value_type = T;
+
+	[[nodiscard]]
+	T load() const noexcept {
+		auto words = _Words{};
+		while (true) {
+			auto const sequence = _sequence.load(std::memory_order::acquire);
+			if (sequence % 2 == 0) {
+				// Acquiring the words keeps the second load of the sequence number after them.
+				for (auto const i : indices(words)) {
+					words[i] = _words[i].load(std::memory_order::acquire);
+				}
+				if (_sequence.load(std::memory_order::relaxed) == sequence) {
+					break;
+				}
+			}
+		}
+		auto value = T{};
+		std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+		return value;
+	}
+
+	void store(T const& value) noexcept {
+		update([&](T& stored_value) { stored_value = value; });
+	}
+	/*
+		Calls update_value with a reference to a copy of the value, which is then stored.
+		Only the calling thread can write while update_value runs.
+	*/
+	template<std::invocable<T&> _Update>
+	void update(_Update&& update_value) noexcept(std::is_nothrow_invocable_v<_Update, T&>) {
+		auto sequence = _sequence.load(std::memory_order::relaxed);
+		do {
+			while (sequence % 2 != 0) {
+				sequence = _sequence.load(std::memory_order::relaxed);
+			}
+		} while (!_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order::acquire, std::memory_order::relaxed));
+
+		// If update_value throws, the value is left as it was.
+		auto const unlock = Cleanup{[&] { _sequence.store(sequence + 2, std::memory_order::release); }};
+
+		auto words = _Words{};
+		for (auto const i : indices(words)) {
+			words[i] = _words[i].load(std::memory_order::relaxed);
+		}
+		auto value = T{};
+		std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+
+		std::forward<_Update>(update_value)(value);
+
+		std::memcpy(words.data(), &value, sizeof(T));
+		// A reader that sees any of the new words also sees the odd sequence number stored before them.
+		for (auto const i : indices(words)) {
+			_words[i].store(words[i], std::memory_order::release);
+		}
+	}
+
+	SeqLock() noexcept :
+		SeqLock{T{}}
+	{}
+	explicit SeqLock(T const& value) noexcept {
+		auto words = _Words{};
+		std::memcpy(words.data(), &value, sizeof(T));
+		for (auto const i : indices(words)) {
+			_words[i].store(words[i], std::memory_order::relaxed);
+		}
+	}
+
+	SeqLock(SeqLock const&) = delete;
+	SeqLock& operator=(SeqLock const&) = delete;
+
+private:
+	using _Word = std::uintptr_t;
+	using _Words = std::array<_Word, (sizeof(T) + sizeof(_Word) - 1)/sizeof(_Word)>;
+
+	std::atomic<std::uint64_t> _sequence{};
+	std::array<std::atomic<_Word>, std::tuple_size_v<_Words>> _words;
+};
+
+//------------------------------
+
+/*
+	A pool of worker threads that run tasks with work stealing.
+	The tasks of a job are numbered, and every participating thread starts out with an equal share of the numbers.
+	A thread that has run out of tasks steals half of the remaining tasks of another thread.
+	The thread that starts a job participates in it and returns when all of the tasks have been run.
+*/
+class ThreadPool final {
+public:
+	/*
+		Calls function with every index from 0 to count - 1 on the threads of the pool, in no particular order.
+		If a task throws an exception, the remaining tasks are still run and the first exception is rethrown.
+		Calling this from within a task of the same pool runs the tasks on the calling thread.
+		The task indices of a job are 32 bits, so larger counts are run as several jobs one after another.
+	*/
+	template<std::invocable<std::size_t> _Function>
+	void for_each_index(std::size_t const count, _Function&& function) {
+		if (count <= 1 || _workers.empty() || _current_pool == this) {
+			for (auto const index : Range{count}) {
+				function(index);
+			}
+			return;
+		}
+
+		auto const lock = std::scoped_lock{_job_mutex};
+
+		_job_function = &function;
+		_job_invoker = [](void* const function, std::size_t const index) {
+			(*static_cast<std::remove_reference_t<_Function>*>(function))(index);
+		};
+
+		for (auto first_index = std::size_t{}; first_index < count;) {
+			auto const job_size = std::min(count - first_index, _max_job_size);
+			_run_job(first_index, job_size);
+			first_index += job_size;
+		}
+
+		if (auto const exception = std::exchange(_job_exception, nullptr)) {
+			std::rethrow_exception(exception);
+		}
+	}
+
+	/*
+		Returns the number of threads that run the tasks of a job, including the thread that starts it.
+	*/
+	[[nodiscard]]
+	std::size_t thread_count() const noexcept {
+		return _ranges.size();
+	}
+
+	/*
+		Returns a pool that is shared by the whole program, which has one thread per hardware thread.
+	*/
+	[[nodiscard]]
+	static ThreadPool& shared() {
+		static auto pool = ThreadPool{};
+		return pool;
+	}
+
+	/*
+		thread_count is the number of threads that run tasks, including the thread that starts a job.
+	*/
+	explicit ThreadPool(std::size_t const thread_count = std::max(std::thread::hardware_concurrency(), 1u)) :
+		_ranges(std::max(thread_count, std::size_t{1}))
+	{
+		_workers.reserve(_ranges.size() - 1);
+		for (auto const participant : Range{_ranges.size() - 1}) {
+			_workers.emplace_back([this, participant] { _run_worker(participant); });
+		}
+	}
+	~ThreadPool() {
+		_is_stopping = true;
+		_job_generation.fetch_add(1, std::memory_order::release);
+		_job_generation.notify_all();
+	}
+
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+
+private:
+	/*
+		The remaining tasks of a participant are stored as the first and past-the-end 
+		task indices in the low and high halves of one integer, so that they can be changed atomically.
+	*/
+	struct alignas(64) _TaskRange : std::atomic<std::uint64_t> {};
+
+	static constexpr auto _max_job_size = std::size_t{0xffff'ffff};
+
+	[[nodiscard]]
+	static std::uint64_t _pack_range(std::size_t const start, std::size_t const end) noexcept {
+		return static_cast<std::uint64_t>(end) << 32 | static_cast<std::uint64_t>(start);
+	}
+	[[nodiscard]]
+	static std::pair<std::size_t, std::size_t> _unpack_range(std::uint64_t const range) noexcept {
+		return {static_cast<std::size_t>(range & 0xffff'ffff), static_cast<std::size_t>(range >> 32)};
+	}
+
+	/*
+		Runs the tasks with indices from first_index to first_index + size - 1, and returns when all of them have been run.
+	*/
+	void _run_job(std::size_t const first_index, std::size_t const size) {
+		_job_first_index = first_index;
+
+		auto const participant_count = _ranges.size();
+		for (auto const participant : Range{participant_count}) {
+			_ranges[participant].store(
+				_pack_range(size*participant/participant_count, size*(participant + 1)/participant_count), 
+				std::memory_order::relaxed
+			);
+		}
+		
+		_active_worker_count.store(_workers.size(), std::memory_order::relaxed);
+		_job_generation.fetch_add(1, std::memory_order::release);
+		_job_generation.notify_all();
+
+		_participate(participant_count - 1);
+
+		for (auto active = _active_worker_count.load(); active; active = _active_worker_count.load()) {
+			_active_worker_count.wait(active);
+		}
+	}
+
+	void _run_worker(std::size_t const participant) {
+		_current_pool = this;
+		for (auto generation = std::uint64_t{};;) {
+			_job_generation.wait(generation, std::memory_order::acquire);
+			generation = _job_generation.load(std::memory_order::acquire);
+			if (_is_stopping) {
+				return;
+			}
+			_participate(participant);
+			if (_active_worker_count.fetch_sub(1, std::memory_order::acq_rel) == 1) {
+				_active_worker_count.notify_all();
+			}
+		}
+	}
+
+	void _participate(std::size_t const participant) {
+		auto* const previous_pool = std::exchange(_current_pool, this);
+		do {
+			for (std::size_t index; _take_task(participant, index);) {
+				_run_task(index);
+			}
+		} while (_steal_tasks(participant));
+		_current_pool = previous_pool;
+	}
+	bool _take_task(std::size_t const participant, std::size_t& index) noexcept {
+		auto& range = _ranges[participant];
+		auto packed = range.load(std::memory_order::relaxed);
+		while (true) {
+			auto const [start, end] = _unpack_range(packed);
+			if (start >= end) {
+				return false;
+			}
+			if (range.compare_exchange_weak(packed, _pack_range(start + 1, end), std::memory_order::acq_rel)) {
+				index = start;
+				return true;
+			}
+		}
+	}
+	bool _steal_tasks(std::size_t const thief) noexcept {
+		for (auto const offset : Range{std::size_t{1}, _ranges.size() - 1}) {
+			auto& victim = _ranges[(thief + offset) % _ranges.size()];
+			auto packed = victim.load(std::memory_order::relaxed);
+			while (true) {
+				auto const [start, end] = _unpack_range(packed);
+				if (start >= end) {
+					break;
+				}
+				auto const middle = start + (end - start)/2;
+				if (victim.compare_exchange_weak(packed, _pack_range(start, middle), std::memory_order::acq_rel)) {
+					_ranges[thief].store(_pack_range(middle, end), std::memory_order::release);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	void _run_task(std::size_t const index) noexcept {
+		try {
+			_job_invoker(_job_function, _job_first_index + index);
+		}
+		catch (...) {
+			auto const lock = std::scoped_lock{_exception_mutex};
+			if (!_job_exception) {
+				_job_exception = std::current_exception();
+			}
+		}
+	}
+
+	// The participant at the last index is the thread that starts the job.
+	std::vector<_TaskRange> _ranges;
+
+	std::mutex _job_mutex;
+	void* _job_function{};
+	void (*_job_invoker)(void*, std::size_t){};
+	// The task indices within a job are offset by this to get the indices that are passed to the function.
+	std::size_t _job_first_index{};
+	std::atomic<std::uint64_t> _job_generation{};
+	std::atomic<std::size_t> _active_worker_count{};
+
+	std::mutex _exception_mutex;
+	std::exception_ptr _job_exception;
+
+	std::atomic<bool> _is_stopping{};
+	// Declared last so that the threads are joined before anything else is destroyed.
+	std::vector<std::jthread> _workers;
+
+	static inline thread_local ThreadPool* _current_pool{};
+};
+
+//------------------------------
+
+/*
+	A part of a recursive range that is traversed by one task in a parallel traversal.
+*/
+template<typename T>
+struct TraversalPart {
+	T* node;
+	// Whether the part consists of the whole subtree of the node, or only the node itself.
+	bool is_subtree;
+};
+
+/*
+	Splits a recursive range into at least part_count parts in pre-order, if it has that many elements.
+	The parts are single nodes and whole subtrees.
+*/
+template<IsRecursiveRange T>
+[[nodiscard]]
+std::vector<TraversalPart<T>> partition_recursive_range(T& range, std::size_t const part_count) {
+	auto parts = std::vector{TraversalPart<T>{&range, true}};
+	for (auto has_split = true; has_split && parts.size() < part_count;) {
+		has_split = false;
+		auto split_parts = std::vector<TraversalPart<T>>{};
+		split_parts.reserve(parts.size()*2);
+		for (auto const part : parts) {
+			if (part.is_subtree && std::ranges::begin(*part.node) != std::ranges::end(*part.node)) {
+				split_parts.push_back({part.node, false});
+				for (auto& child : *part.node) {
+					split_parts.push_back({&child, true});
+				}
+				has_split = true;
+			}
+			else {
+				split_parts.push_back(part);
+			}
+		}
+		parts = std::move(split_parts);
+	}
+	return parts;
+}
+
+/*
+	Calls function with every element of a part of a recursive range, in pre-order.
+*/
+template<IsRecursiveRange T>
+void for_each_in_part(TraversalPart<T> const part, auto&& function) {
+	if (part.is_subtree) {
+		for (auto& element : flatten(*part.node)) {
+			function(element);
+		}
+	}
+	else {
+		function(*part.node);
+	}
+}
+
+/*
+	The number of parts that a recursive range is split into per thread, so that there is something to steal.
+*/
+inline constexpr auto parallel_parts_per_thread = std::size_t{8};
+
+/*
+	Calls visitor with every element of a recursive range, including the range itself, 
+	on the threads of a pool and in no particular order.
+*/
+template<IsRecursiveRange T, std::invocable<T&> _Visitor>
+void for_each_parallel(T& range, _Visitor&& visitor, ThreadPool& pool = ThreadPool::shared()) {
+	auto const parts = partition_recursive_range(range, pool.thread_count()*parallel_parts_per_thread);
+	pool.for_each_index(parts.size(), [&](std::size_t const index) {
+		for_each_in_part(parts[index], visitor);
+	});
+}
+
+/*
+	Returns pointers to the elements of a recursive range, including the range itself, that satisfy a predicate.
+	The predicate is called on the threads of a pool, but the result is in the same order as flatten(range) would give.
+*/
+template<IsRecursiveRange T, std::predicate<T&> _Predicate>
+[[nodiscard]]
+std::vector<T*> find_all_parallel(T& range, _Predicate&& predicate, ThreadPool& pool = ThreadPool::shared()) {
+	auto const parts = partition_recursive_range(range, pool.thread_count()*parallel_parts_per_thread);
+	auto found_in_parts = std::vector<std::vector<T*>>(parts.size());
+	pool.for_each_index(parts.size(), [&](std::size_t const index) {
+		for_each_in_part(parts[index], [&](T& element) {
+			if (predicate(element)) {
+				found_in_parts[index].push_back(&element);
+			}
+		});
+	});
+
+	auto found = std::vector<T*>{};
+	found.reserve(std::transform_reduce(found_in_parts.begin(), found_in_parts.end(), std::size_t{}, 
+		std::plus{}, [](auto const& part) { return part.size(); }));
+	for (auto const& part : found_in_parts) {
+		found.insert(found.end(), part.begin(), part.end());
+	}
+	return found;
+}
+
+/*
+	Transforms every element of a recursive range, including the range itself, and reduces the results into one value.
+	The elements are transformed on the threads of a pool. The results are reduced in the order flatten(range) 
+	would give them in, so reduce only needs to be associative and the result is the same every time for a given pool.
+*/
+template<IsRecursiveRange T, typename _Value, typename _Reduce, std::invocable<T&> _Transform> 
+	requires std::movable<_Value> && std::invocable<_Reduce&, _Value, _Value>
+[[nodiscard]]
+_Value transform_reduce_parallel(
+	T& range, _Value initial_value, _Reduce&& reduce, _Transform&& transform, 
+	ThreadPool& pool = ThreadPool::shared()
+) {
+	auto const parts = partition_recursive_range(range, pool.thread_count()*parallel_parts_per_thread);
+	auto part_values = std::vector<std::optional<_Value>>(parts.size());
+	pool.for_each_index(parts.size(), [&](std::size_t const index) {
+		auto& part_value = part_values[index];
+		for_each_in_part(parts[index], [&](T& element) {
+			part_value = part_value ? 
+				reduce(std::move(*part_value), _Value(transform(element))) : 
+				_Value(transform(element));
+		});
+	});
+
+	for (auto& part_value : part_values) {
+		if (part_value) {
+			initial_value = reduce(std::move(initial_value), std::move(*part_value));
+		}
+	}
+	return initial_value;
+}
+
+} // namespace utils
+
+//------------------------------
+
+/*
+	Unicode support library.
+*/
+namespace unicode {
+
+/*
+	Enables UTF-8 encoded console output on Windows.
+	Pretty much all other platforms use UTF-8 by default.
+*/
+void enable_utf8_console();
+
+//------------------------------
+
+/*
+	Converts a UTF-8 encoded char string to a UTF-16 encoded char16 string.
+	Returns the length of the converted string, in code point units (char16_t).
+	If no value is returned then the output span is too small to fit the whole converted string,
+	or the input is not valid UTF-8.
+*/
+std::optional<std::size_t> utf8_to_utf16(std::string_view input, std::span<char16_t> output);
+/*
+	Converts a UTF-8 encoded string to a UTF-16 encoded std::u16string.
+*/
+[[nodiscard]]
+std::u16string utf8_to_utf16(std::string_view input);
+
+/*
+	Converts a UTF-16 encoded char16 string to a UTF-8 encoded char string.
+	Returns the length of the converted string, in code point units (char).
+	If no value is returned then the output span is too small to fit the whole converted string,
+	or the input is not valid UTF-16.
+*/
+std::optional<std::size_t> utf16_to_utf8(std::u16string_view input, std::span<char> output);
+/*
+	Converts a UTF-16 char16 string to a UTF-8 encoded std::string.
+*/
+[[nodiscard]]
+std::string utf16_to_utf8(std::u16string_view input);
+
+/*
+	Returns the number of UTF-16 code units (char16_t) that the UTF-8 encoded input 
+	string consists of when it is converted to UTF-16.
+	The result is only meaningful if the input is valid UTF-8.
+*/
+[[nodiscard]]
+std::size_t utf16_length_of(std::string_view input) noexcept;
+/*
+	Returns the number of UTF-8 code units (char) that the UTF-16 encoded input 
+	string consists of when it is converted to UTF-8.
+	The result is only meaningful if the input is valid UTF-16.
+*/
+[[nodiscard]]
+std::size_t utf8_length_of(std::u16string_view input) noexcept;
+
+//------------------------------
+
+/*
+	Returns the number of UTF-8 code points a character starting with 
+	first_code_point_in_character consists of in total.
+	Returns 0 if the code point is not the first one in a character.
+	Returns -1 if the code point is an invalid UTF-8 code point.
+*/
+[[nodiscard]]
+constexpr int code_point_count(char const first_code_point_in_character) noexcept {
+	// http://www.unicode.org/versions/Unicode12.1.0/ch03.pdf , page 126
+	if (!(first_code_point_in_character & 0x80)) // 0xxxxxxx
+		return 1;
+	if ((first_code_point_in_character & 0xc0) == 0x80) // 10??????
+		return 0;
+	if ((first_code_point_in_character & 0xe0) == 0xc0) // 110yyyyy
+		return 2;
+	if ((first_code_point_in_character & 0xf0) == 0xe0) // 1110zzzz
+		return 3;
+	if ((first_code_point_in_character & 0xf8) == 0xf0) // 11110uuu
+		return 4;
+	return -1;
+}
+
+/*
+	Returns the number of UTF-16 code points a character starting with 
+	first_code_point_in_character consists of in total.
+	Returns 0 if the code point is not the first one in a character.
+	Returns -1 if the code point is an invalid UTF-16 code point.
+*/
+[[nodiscard]]
+constexpr int code_point_count(char16_t const first_code_point_in_character) noexcept {
+	// http://www.unicode.org/versions/Unicode12.1.0/ch03.pdf , page 125
+	if ((first_code_point_in_character & 0xfc00) == 0xd800) // 110110wwwwxxxxxx
+		return 2;
+	if ((first_code_point_in_character & 0xfc00) == 0xdc00) // 110111xxxxxxxxxx
+		return 0;
+	return 1; // xxxxxxxxxxxxxxxx
+}
+
+/*
+	Returns whether the passed code point is the start of a UTF-8 encoded character.
+*/
+[[nodiscard]]
+constexpr bool is_first_code_point(char const code_point) noexcept {
+	return (code_point & 0xc0) != 0x80;
+}
+
+/*
+	Returns whether p_unit is the start of a UTF-16 encoded character
+*/
+[[nodiscard]]
+constexpr bool is_first_code_point(char16_t const code_point) noexcept {
+	return (code_point & 0xfc00) != 0xdc00;
+}
+
+template<typename T>
+concept IsCodePoint = utils::IsAnyOf<T, char, char16_t>;
+
+/*
+	Returns the index of the code point at a certain character index in a UTF-8 or UTF-16 encoded string.
+	If character_index is outside of the string, the size of the string is returned.
+*/
+template<IsCodePoint T>
+[[nodiscard]]
+constexpr std::size_t code_point_index(std::basic_string_view<T> const string, std::size_t const character_index) 
+{
+	if (!character_index) {
+		return {};
+	}
+	if (character_index >= string.size()) {
+		return string.size();
+	}
+
+	auto const position = std::ranges::find_if(
+		string, [character_index, char_count = std::size_t{}](T const code_point) mutable {
+			return is_first_code_point(code_point) && char_count++ == character_index;
+		}
+	);
+	return position - string.begin();
+}
+
+/*
+	Returns the index of the character that the code point at code_point_index in the UTF-8 or UTF-16 encoded string belongs to.
+	If code_point_index is outside of the string, the last character index is returned.
+	If code_point_index is past the start of a character but before the next one, it returns the index of the character it is part of.
+*/
+template<IsCodePoint T>
+[[nodiscard]]
+constexpr std::size_t character_index(std::basic_string_view<T> const string, std::size_t const code_point_index) 
+{
+	if (!code_point_index) {
+		return {};
+	}
+	if (code_point_index >= string.size()) {
+		return string.size();
+	}
+
+	return std::ranges::count_if(
+		string.begin() + 1, string.begin() + code_point_index + 1,
+		[](T const code_point) { return is_first_code_point(code_point); }
+	);
+}
+
+/*
+	Vectorized implementations of character_count, which are used when it is not constant evaluated.
+	They count the code points that are not the first one in a character and subtract them from the size.
+*/
+[[nodiscard]]
+std::size_t character_count_vectorized(std::string_view string) noexcept;
+[[nodiscard]]
+std::size_t character_count_vectorized(std::u16string_view string) noexcept;
+
+/*
+	Returns the number of unicode characters that a UTF-8 or UTF-16 string consists of.
+*/
+template<IsCodePoint T>
+[[nodiscard]]
+constexpr std::size_t character_count(std::basic_string_view<T> const string) noexcept {
+	if (std::is_constant_evaluated()) {
+		return static_cast<std::size_t>(std::ranges::count_if(string, [](T const code_point) { 
+			return is_first_code_point(code_point); 
+		}));
+	}
+	return character_count_vectorized(string);
+}
+
+#ifdef BUILD_TESTING
 static_assert(
 	code_point_count('a') == 1 &&
 	code_point_count("å"[0]) == 2 &&
@@ -1238,9 +2250,203 @@ static_assert(
 	"character_index does not work correctly with UTF-8."
 );
 static_assert(
-	character_index(std::u16string_view{u"🪢 här √ är knut"}, 11) == 10 &&
-	character_index(std::u16string_view{u"🪢 här 🪢 är knut"}, 12) == 10, 
-	"character_index does not work correctly with UTF-16."
+	character_count(std::string_view{"🪢 här √ är knut"}) == 15 &&
+	character_count(std::string_view{""}) == 0,
+	"character_count does not work correctly with UTF-8."
+);
+static_assert(
+	character_count(std::u16string_view{u"🪢 här √ är knut"}) == 15 &&
+	character_count(std::u16string_view{u""}) == 0,
+	"character_count does not work correctly with UTF-16."
+);
+static_assert(
+	character_index(std::u16string_view{u"🪢 här √ är knut"}, 11) == 10 &&
+	character_index(std::u16string_view{u"🪢 här 🪢 är knut"}, 12) == 10, 
+	"character_index does not work correctly with UTF-16."
+);
+#endif // BUILD_TESTING
+
+//------------------------------
+
+/*
+	Maps between character indices and code point indices in a long UTF-8 or UTF-16 string
+	in logarithmic time, instead of scanning from the start of the string like 
+	code_point_index and character_index do. It does this by storing a checkpoint for 
+	every checkpoint_interval characters, so that only the characters between the closest 
+	checkpoint and the requested index need to be scanned.
+
+	The index refers to the string through a view and does not own it. When the string is 
+	edited, call insert, erase or replace with the new string so that only the checkpoints 
+	around the edit are updated.
+
+	For strings shorter than the checkpoint interval, the free functions are just as fast 
+	and the index only forwards to them.
+*/
+template<IsCodePoint T>
+class CharacterIndex final {
+public:
+	using value_type = T;
+	using StringView = std::basic_string_view<T>;
+
+	static constexpr auto default_checkpoint_interval = std::size_t{128};
+
+	/*
+		Returns the index of the code point at a certain character index.
+		If character_index is outside of the string, the size of the string is returned.
+	*/
+	[[nodiscard]]
+	constexpr std::size_t code_point_index(std::size_t const character_index) const {
+		if (character_index >= _character_count) {
+			return _string.size();
+		}
+		auto const checkpoint = *std::ranges::prev(std::ranges::upper_bound(
+			_checkpoints, character_index, {}, &Checkpoint::character_index
+		));
+		return checkpoint.code_point_index + unicode::code_point_index(
+			_string.substr(checkpoint.code_point_index), 
+			character_index - checkpoint.character_index
+		);
+	}
+
+	/*
+		Returns the index of the character that the code point at code_point_index belongs to.
+		If code_point_index is outside of the string, the number of characters is returned.
+	*/
+	[[nodiscard]]
+	constexpr std::size_t character_index(std::size_t const code_point_index) const {
+		if (code_point_index >= _string.size()) {
+			return _character_count;
+		}
+		auto const checkpoint = *std::ranges::prev(std::ranges::upper_bound(
+			_checkpoints, code_point_index, {}, &Checkpoint::code_point_index
+		));
+		return checkpoint.character_index + unicode::character_index(
+			_string.substr(checkpoint.code_point_index), 
+			code_point_index - checkpoint.code_point_index
+		);
+	}
+
+	[[nodiscard]]
+	constexpr std::size_t character_count() const noexcept {
+		return _character_count;
+	}
+
+	[[nodiscard]]
+	constexpr StringView string() const noexcept {
+		return _string;
+	}
+
+	/*
+		Updates the index after inserted_size code points were inserted at code_point_index.
+		new_string is the string after the insertion.
+	*/
+	constexpr void insert(StringView const new_string, std::size_t const code_point_index, std::size_t const inserted_size) {
+		replace(new_string, code_point_index, 0, inserted_size);
+	}
+	/*
+		Updates the index after erased_size code points were erased at code_point_index.
+		new_string is the string after the erasure.
+	*/
+	constexpr void erase(StringView const new_string, std::size_t const code_point_index, std::size_t const erased_size) {
+		replace(new_string, code_point_index, erased_size, 0);
+	}
+	/*
+		Updates the index after erased_size code points at code_point_index were replaced 
+		by inserted_size new code points. new_string is the string after the replacement.
+		The edited range must start and end at character boundaries.
+		Only the checkpoints around the edited range are recalculated, the ones after it are shifted.
+	*/
+	constexpr void replace(
+		StringView const new_string, std::size_t const code_point_index, 
+		std::size_t const erased_size, std::size_t const inserted_size) 
+	{
+		_string = new_string;
+
+		// The last checkpoint strictly before the edit, and the first one after it.
+		auto const first = code_point_index ? 
+			std::ranges::prev(std::ranges::lower_bound(_checkpoints, code_point_index, {}, &Checkpoint::code_point_index)) : 
+			_checkpoints.begin();
+		auto const last = std::ranges::lower_bound(
+			first + 1, _checkpoints.end(), code_point_index + erased_size, {}, &Checkpoint::code_point_index
+		);
+
+		auto const old_segment_length = (last == _checkpoints.end() ? _character_count : last->character_index) - 
+			first->character_index;
+
+		auto const segment_start = first->code_point_index;
+		auto const segment_end = last == _checkpoints.end() ? 
+			new_string.size() : last->code_point_index + inserted_size - erased_size;
+		auto const new_segment_length = unicode::character_count(new_string.substr(segment_start, segment_end - segment_start));
+
+		for (auto& checkpoint : std::ranges::subrange{last, _checkpoints.end()}) {
+			checkpoint.code_point_index = checkpoint.code_point_index + inserted_size - erased_size;
+			checkpoint.character_index = checkpoint.character_index + new_segment_length - old_segment_length;
+		}
+		_character_count = _character_count + new_segment_length - old_segment_length;
+
+		auto const segment_checkpoints = _find_checkpoints(*first, segment_end);
+		auto const erased_end = _checkpoints.erase(first + 1, last);
+		_checkpoints.insert(erased_end, segment_checkpoints.begin(), segment_checkpoints.end());
+	}
+
+	constexpr CharacterIndex() = default;
+	constexpr explicit CharacterIndex(StringView const string, std::size_t const checkpoint_interval = default_checkpoint_interval) :
+		_string{string},
+		_checkpoint_interval{checkpoint_interval},
+		_character_count{unicode::character_count(string)},
+		_checkpoints{Checkpoint{}}
+	{
+		auto const checkpoints = _find_checkpoints(Checkpoint{}, string.size());
+		_checkpoints.insert(_checkpoints.end(), checkpoints.begin(), checkpoints.end());
+	}
+
+private:
+	struct Checkpoint {
+		std::size_t character_index;
+		std::size_t code_point_index;
+	};
+
+	/*
+		Returns the checkpoints that should come after start and before the code point at end.
+	*/
+	[[nodiscard]]
+	constexpr std::vector<Checkpoint> _find_checkpoints(Checkpoint const start, std::size_t const end) const {
+		auto result = std::vector<Checkpoint>{};
+		auto character_index = start.character_index;
+		for (auto code_point_index = start.code_point_index + 1; code_point_index < end; ++code_point_index) {
+			if (is_first_code_point(_string[code_point_index]) && 
+				++character_index - start.character_index == _checkpoint_interval*(result.size() + 1)) 
+			{
+				result.push_back({character_index, code_point_index});
+			}
+		}
+		return result;
+	}
+
+	StringView _string;
+	std::size_t _checkpoint_interval{default_checkpoint_interval};
+	std::size_t _character_count{};
+	std::vector<Checkpoint> _checkpoints{Checkpoint{}};
+};
+
+template<typename T>
+CharacterIndex(std::basic_string<T> const&) -> CharacterIndex<T>;
+
+#ifdef BUILD_TESTING
+static_assert(
+	[] {
+		constexpr auto string = std::string_view{"🪢 här √ är knut, 🪢 här √ är knut, 🪢 här √ är knut"};
+		auto const index = CharacterIndex{string, 4};
+		for (auto const i : utils::Range{string.size()}) {
+			if (index.character_index(i) != character_index(string, i) ||
+				i < index.character_count() && index.code_point_index(i) != code_point_index(string, i))
+			{
+				return false;
+			}
+		}
+		return index.character_count() == 49;
+	}(),
+	"avo::unicode::CharacterIndex does not agree with the free functions."
 );
 #endif // BUILD_TESTING
 
@@ -3664,6 +4870,7 @@ namespace avo {
 
 /*
 	To generate a new unique ID, use the function Id::next().
+	To create an ID from a name at compile time, use Id::from_name() or the _id literal.
 	To create an ID with a specific value (not guaranteed to be unique), use the constructor.
 	An ID which converts to Id::value_type{} is considered invalid, and is the default value.
 */
@@ -3691,17 +4898,74 @@ public:
 
 	/*
 		Generates a new unique ID, assuming all IDs are generated by this function.
+		It is safe to call from multiple threads at the same time. 
+		Every thread reserves a block of IDs at a time from a shared atomic counter,
+		so IDs generated by different threads are not ordered by the time they were generated.
 	*/
 	[[nodiscard]]
 	static Id next() noexcept {
-		static auto counter = value_type{};
-		return Id{++counter};
+		constexpr auto block_size = value_type{1024};
+
+		static constinit auto counter = std::atomic<value_type>{};
+		thread_local constinit auto next_value = value_type{};
+		thread_local constinit auto block_end = value_type{};
+		
+		if (next_value == block_end) {
+			// 0 is the invalid ID, so the first block starts at 1.
+			next_value = counter.fetch_add(block_size, std::memory_order_relaxed) + 1;
+			block_end = next_value + block_size;
+		}
+		return Id{next_value++};
+	}
+
+	/*
+		Creates an ID by hashing a name at compile time. The same name always gives the same ID.
+		The most significant bit of named IDs is always set, which means that they never 
+		collide with IDs generated by Id::next().
+	*/
+	[[nodiscard]]
+	static consteval Id from_name(std::string_view const name) noexcept {
+		// 64 bit FNV-1a
+		auto hash = value_type{0xcbf29ce484222325};
+		for (auto const character : name) {
+			hash = (hash ^ static_cast<unsigned char>(character)) * value_type{0x100000001b3};
+		}
+		return Id{hash | value_type{1} << 63};
 	}
 
 private:
 	value_type _count{};
 };
 
+inline namespace id_literals {
+
+/*
+	Creates an ID by hashing a name at compile time, see Id::from_name.
+*/
+[[nodiscard]]
+consteval Id operator"" _id(char const* const name, std::size_t const length) noexcept {
+	return Id::from_name({name, length});
+}
+
+} // namespace id_literals
+
+namespace literals {
+
+using namespace id_literals;
+
+} // namespace literals
+
+#ifdef BUILD_TESTING
+static_assert(
+	"primary"_id == Id::from_name("primary") && "primary"_id != "secondary"_id,
+	"avo::Id named literals do not work."
+);
+static_assert(
+	("primary"_id).value() >> 63 && Id::from_name("").value() >> 63,
+	"avo::Id named IDs could collide with generated IDs."
+);
+#endif // BUILD_TESTING
+
 } // namespace avo
 
 template<>
@@ -3720,6 +4984,316 @@ struct std::hash<avo::Id> {
 
 namespace avo {
 
+/*
+	A hash map from IDs to values which stores all entries in a single flat array,
+	using open addressing with linear probing. Looking up an ID is a hash of the ID 
+	followed by a scan of consecutive slots, without any per-entry allocations or 
+	pointer chasing like with std::unordered_map.
+
+	The invalid ID (Id{}) marks empty slots, so it cannot be used as a key.
+	Iterators, pointers and references to entries are invalidated by insertions and erasures.
+	Values must not throw when moved, since entries are moved between slots by destroying 
+	the old slot and constructing the entry in its place.
+*/
+template<std::movable _Value> requires std::default_initializable<_Value> && std::is_nothrow_move_constructible_v<_Value>
+class IdMap final {
+public:
+	using key_type = Id;
+	using mapped_type = _Value;
+	// Like in std::unordered_map, the ID of an entry can not be modified through an iterator.
+	// Slots are therefore replaced by destroying and constructing them instead of by assignment.
+	using value_type = std::pair<Id const, _Value>;
+
+private:
+	using _Container = std::vector<value_type>;
+
+	template<bool is_const>
+	class _Iterator {
+	public:
+		using BaseIterator = std::ranges::iterator_t<std::conditional_t<is_const, _Container const, _Container>>;
+
+		using value_type = IdMap::value_type;
+		using reference = std::iter_reference_t<BaseIterator>;
+		using pointer = std::remove_reference_t<reference>*;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+
+		_Iterator& operator++() {
+			_base_iterator = std::find_if(_base_iterator + 1, _end, _is_occupied);
+			return *this;
+		}
+		_Iterator operator++(int) {
+			auto before = *this;
+			++*this;
+			return before;
+		}
+
+		[[nodiscard]]
+		reference operator*() const {
+			return *_base_iterator;
+		}
+		[[nodiscard]]
+		pointer operator->() const {
+			return &*_base_iterator;
+		}
+
+		[[nodiscard]]
+		bool operator==(_Iterator const& other) const noexcept {
+			return _base_iterator == other._base_iterator;
+		}
+
+		// Allows conversion from a mutable iterator to a const iterator.
+		operator _Iterator<true>() const requires (!is_const) {
+			return _Iterator<true>{_base_iterator, _end};
+		}
+
+		_Iterator() = default;
+		_Iterator(BaseIterator const base_iterator, BaseIterator const end) :
+			_base_iterator{base_iterator},
+			_end{end}
+		{}
+
+	private:
+		BaseIterator _base_iterator;
+		BaseIterator _end;
+	};
+
+public:
+	using Iterator = _Iterator<false>;
+	using ConstIterator = _Iterator<true>;
+
+	[[nodiscard]]
+	Iterator begin() {
+		return Iterator{std::ranges::find_if(_slots, _is_occupied), _slots.end()};
+	}
+	[[nodiscard]]
+	ConstIterator begin() const {
+		return ConstIterator{std::ranges::find_if(_slots, _is_occupied), _slots.end()};
+	}
+	[[nodiscard]]
+	Iterator end() {
+		return Iterator{_slots.end(), _slots.end()};
+	}
+	[[nodiscard]]
+	ConstIterator end() const {
+		return ConstIterator{_slots.end(), _slots.end()};
+	}
+
+	[[nodiscard]]
+	std::size_t size() const noexcept {
+		return _size;
+	}
+	[[nodiscard]]
+	bool empty() const noexcept {
+		return !_size;
+	}
+
+	[[nodiscard]]
+	Iterator find(Id const id) {
+		return _iterator_at(_find_slot(id));
+	}
+	[[nodiscard]]
+	ConstIterator find(Id const id) const {
+		return _iterator_at(_find_slot(id));
+	}
+	[[nodiscard]]
+	bool contains(Id const id) const {
+		return _find_slot(id) != _slots.size();
+	}
+
+	/*
+		Returns the value associated with an ID.
+		Throws std::out_of_range if there is no such entry.
+	*/
+	[[nodiscard]]
+	_Value& at(Id const id) {
+		return const_cast<_Value&>(std::as_const(*this).at(id));
+	}
+	[[nodiscard]]
+	_Value const& at(Id const id) const {
+		if (auto const slot = _find_slot(id); slot != _slots.size()) {
+			return _slots[slot].second;
+		}
+		throw std::out_of_range{fmt::format("avo::IdMap does not contain the ID {}.", id.value())};
+	}
+
+	/*
+		Returns the value associated with an ID, inserting a default value if there is no such entry.
+	*/
+	_Value& operator[](Id const id) {
+		return _insert(id).first->second;
+	}
+
+	/*
+		Inserts a value if the ID is not already in the map.
+		Returns an iterator to the entry with the ID and whether a new entry was inserted.
+	*/
+	std::pair<Iterator, bool> insert(value_type entry) {
+		auto result = _insert(entry.first);
+		if (result.second) {
+			result.first->second = std::move(entry.second);
+		}
+		return result;
+	}
+	/*
+		Inserts a value or assigns it to the existing entry with the same ID.
+	*/
+	std::pair<Iterator, bool> insert_or_assign(Id const id, _Value value) {
+		auto result = _insert(id);
+		result.first->second = std::move(value);
+		return result;
+	}
+
+	/*
+		Removes the entry with an ID if there is one.
+		Returns the number of removed entries.
+	*/
+	std::size_t erase(Id const id) {
+		auto slot = _find_slot(id);
+		if (slot == _slots.size()) {
+			return 0;
+		}
+		// Backward shift deletion, so that no tombstones are needed.
+		// Entries after the erased one that were displaced past it are moved back.
+		for (auto next = _next_slot(slot); _is_occupied(_slots[next]); next = _next_slot(next)) {
+			auto const ideal = _ideal_slot(_slots[next].first);
+			if ((next - ideal & _mask()) >= (next - slot & _mask())) {
+				_replace(_slots[slot], std::move(_slots[next]));
+				slot = next;
+			}
+		}
+		_replace(_slots[slot], value_type{});
+		--_size;
+		return 1;
+	}
+
+	void clear() {
+		for (auto& slot : _slots | std::views::filter(_is_occupied)) {
+			_replace(slot, value_type{});
+		}
+		_size = 0;
+	}
+
+	/*
+		Makes room for at least size entries without rehashing.
+	*/
+	void reserve(std::size_t const size) {
+		if (size*4 > _slots.size()*3) {
+			_rehash(std::bit_ceil(size*4/3 + 1));
+		}
+	}
+
+	[[nodiscard]]
+	bool operator==(IdMap const& other) const requires std::equality_comparable<_Value> {
+		return _size == other._size && std::ranges::all_of(*this, [&](value_type const& entry) {
+			auto const other_entry = other.find(entry.first);
+			return other_entry != other.end() && other_entry->second == entry.second;
+		});
+	}
+
+	IdMap() = default;
+	IdMap(std::initializer_list<value_type> const entries) {
+		reserve(entries.size());
+		for (auto const& entry : entries) {
+			insert_or_assign(entry.first, entry.second);
+		}
+	}
+
+	IdMap(IdMap const&) = default;
+	IdMap(IdMap&&) noexcept = default;
+	
+	// Assigning the slot vector element-wise would need assignable slots.
+	IdMap& operator=(IdMap const& other) {
+		return *this = IdMap{other};
+	}
+	IdMap& operator=(IdMap&&) noexcept = default;
+
+private:
+	static void _replace(value_type& slot, value_type&& entry) noexcept {
+		std::destroy_at(&slot);
+		std::construct_at(&slot, std::move(entry));
+	}
+
+	[[nodiscard]]
+	static bool _is_occupied(value_type const& slot) noexcept {
+		return slot.first != Id{};
+	}
+
+	[[nodiscard]]
+	std::size_t _mask() const noexcept {
+		return _slots.size() - 1;
+	}
+	[[nodiscard]]
+	std::size_t _ideal_slot(Id const id) const noexcept {
+		// Fibonacci hashing spreads both sequential and hashed IDs evenly over the slots.
+		return static_cast<std::size_t>((id.value()*0x9e3779b97f4a7c15ull) >> (64 - std::countr_zero(_slots.size())));
+	}
+	[[nodiscard]]
+	std::size_t _next_slot(std::size_t const slot) const noexcept {
+		return slot + 1 & _mask();
+	}
+
+	/*
+		Returns the index of the slot containing the ID, or the number of slots if it is not in the map.
+	*/
+	[[nodiscard]]
+	std::size_t _find_slot(Id const id) const noexcept {
+		if (_slots.empty() || id == Id{}) {
+			return _slots.size();
+		}
+		for (auto slot = _ideal_slot(id);; slot = _next_slot(slot)) {
+			if (_slots[slot].first == id) {
+				return slot;
+			}
+			if (!_is_occupied(_slots[slot])) {
+				return _slots.size();
+			}
+		}
+	}
+
+	[[nodiscard]]
+	Iterator _iterator_at(std::size_t const slot) {
+		return Iterator{_slots.begin() + static_cast<std::ptrdiff_t>(slot), _slots.end()};
+	}
+	[[nodiscard]]
+	ConstIterator _iterator_at(std::size_t const slot) const {
+		return ConstIterator{_slots.begin() + static_cast<std::ptrdiff_t>(slot), _slots.end()};
+	}
+
+	std::pair<Iterator, bool> _insert(Id const id) {
+		if (id == Id{}) {
+			throw std::invalid_argument{"The invalid ID cannot be used as a key in avo::IdMap."};
+		}
+		if (auto const slot = _find_slot(id); slot != _slots.size()) {
+			return {_iterator_at(slot), false};
+		}
+		reserve(_size + 1);
+		
+		auto slot = _ideal_slot(id);
+		while (_is_occupied(_slots[slot])) {
+			slot = _next_slot(slot);
+		}
+		_replace(_slots[slot], value_type{id, _Value{}});
+		++_size;
+		return {_iterator_at(slot), true};
+	}
+
+	void _rehash(std::size_t const slot_count) {
+		auto old_slots = std::exchange(_slots, _Container(std::max(slot_count, std::size_t{8})));
+		for (auto& entry : old_slots | std::views::filter(_is_occupied)) {
+			auto slot = _ideal_slot(entry.first);
+			while (_is_occupied(_slots[slot])) {
+				slot = _next_slot(slot);
+			}
+			_replace(_slots[slot], std::move(entry));
+		}
+	}
+
+	_Container _slots;
+	std::size_t _size{};
+};
+
 enum class CornerType {
 	Round,
 	Cut
@@ -3760,81 +5334,189 @@ static_assert([]{
 }());
 #endif
 
-//------------------------------
+//------------------------------
+
+/*
+	Identifies a listener that was added to an EventListeners instance, so that it can be removed again.
+*/
+enum class EventListenerHandle : std::uint64_t {
+	None = 0
+};
+
+template<typename T>
+class EventListeners;
+
+/*
+	This is a class used to easily manage event listeners. Any type of callable can be a listener.
+	The return type and arguments have to be the same for all listeners added to one instance of EventListeners.
+
+	Small listeners are stored without any heap allocation, see utils::InplaceFunction.
+	notify_all calls the listeners of an immutable snapshot without taking any lock. The snapshot is
+	replaced by the first notification after listeners have been added or removed.
+	This means that a listener can add and remove listeners, but the change will only be visible in the next notification.
+	Replaced snapshots are freed once no notification can still be using them, which is tracked with
+	two reader counts that notifications alternate between, like in epoch-based reclamation.
+	Each listener is stored once and shared between snapshots, so state kept inside a listener 
+	is not reset when other listeners are added or removed.
+
+	Notifications can also be queued from any thread with post, and made later by notify_queued 
+	on a chosen thread, like the UI thread once per frame.
+*/
+template<typename _Return, typename ... _Arguments>
+class EventListeners<_Return(_Arguments...)> final {
+public:
+	using FunctionType = _Return(_Arguments...);
+	using Listener = utils::InplaceFunction<FunctionType>;
+	
+	struct Entry {
+		EventListenerHandle handle;
+		Listener listener;
+	};
+	using ContainerType = std::vector<std::shared_ptr<Entry const>>;
+
+	using QueuedEvent = std::tuple<std::decay_t<_Arguments>...>;
+
+	/*
+		Returns a copy of the listeners as they are at the moment.
+		The copy is not affected by later changes, and shares the listeners themselves.
+	*/
+	[[nodiscard]]
+	ContainerType snapshot() const {
+		auto const reader = _SnapshotReader{*this};
+		return reader.listeners ? *reader.listeners : ContainerType{};
+	}
+
+	class ConstIterator {
+	public:
+		using BaseIterator = std::ranges::iterator_t<ContainerType const>;
+
+		using value_type = Listener;
+		using reference = Listener const&;
+		using pointer = Listener const*;
+		using difference_type = std::iter_difference_t<BaseIterator>;
+		using iterator_category = std::forward_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+
+		ConstIterator& operator++() {
+			++_base_iterator;
+			return *this;
+		}
+		ConstIterator operator++(int) {
+			auto before = *this;
+			++_base_iterator;
+			return before;
+		}
+
+		[[nodiscard]]
+		reference operator*() const {
+			return (*_base_iterator)->listener;
+		}
+		[[nodiscard]]
+		pointer operator->() const {
+			return &(*_base_iterator)->listener;
+		}
 
-template<typename T>
-class EventListeners;
+		[[nodiscard]]
+		bool operator==(ConstIterator const&) const = default;
 
-/*
-	This is a class used to easily manage event listeners. Any type of callable can be a listener.
-	The return type and arguments have to be the same for all listeners added to one instance of EventListeners.
-*/
-template<typename _Return, typename ... _Arguments>
-class EventListeners<_Return(_Arguments...)> final {
-public:
-	using FunctionType = _Return(_Arguments...);
-	using ContainerType = std::vector<std::function<FunctionType>>;
-	
-	using Iterator = std::ranges::iterator_t<ContainerType>;
-	using ConstIterator = std::ranges::iterator_t<ContainerType const>;
-	
+		ConstIterator() = default;
+		explicit ConstIterator(BaseIterator const base_iterator) :
+			_base_iterator{base_iterator}
+		{}
+
+	private:
+		BaseIterator _base_iterator;
+	};
+
+	/*
+		Iterates the listeners as they are at the moment.
+		Unlike snapshot, this must not be used while another thread adds or removes listeners.
+	*/
 	[[nodiscard]]
-	Iterator begin() noexcept {
-		return _listeners.begin();
+	ConstIterator begin() const noexcept {
+		return ConstIterator{_listeners.begin()};
 	}
 	[[nodiscard]]
-	ConstIterator begin() const noexcept {
-		return _listeners.begin();
+	ConstIterator end() const noexcept {
+		return ConstIterator{_listeners.end()};
 	}
+
 	[[nodiscard]]
-	Iterator end() noexcept {
-		return _listeners.end();
+	std::size_t size() const {
+		auto const reader = _SnapshotReader{*this};
+		return reader.listeners ? reader.listeners->size() : 0;
 	}
 	[[nodiscard]]
-	ConstIterator end() const noexcept {
-		return _listeners.end();
+	bool empty() const {
+		return size() == 0;
 	}
 
 	/*
 		Adds a listener to the EventListeners instance that will be called when nofity_all or operator() is called.
+		Returns a handle that can be passed to remove.
 		Equivalent to EventListeners::operator+=.
 	*/
-	void add(std::function<FunctionType> listener) {
-		auto const lock = std::scoped_lock{_mutex};    
-		_listeners.emplace_back(std::move(listener));
+	template<typename _Callable> requires std::constructible_from<Listener, _Callable>
+	EventListenerHandle add(_Callable&& listener) {
+		auto const handle = EventListenerHandle{++_last_handle};
+		_modify([&](ContainerType& listeners) {
+			listeners.push_back(std::make_shared<Entry const>(handle, Listener{std::forward<_Callable>(listener)}));
+			return true;
+		});
+		return handle;
 	}
 	/*
 		Adds a listener to the EventListeners instance that will be called when nofity_all or operator() is called.
 		Equivalent to EventListeners::add.
 	*/
-	EventListeners& operator+=(std::function<FunctionType> listener) {
-		add(std::move(listener));
+	template<typename _Callable> requires std::constructible_from<Listener, _Callable>
+	EventListeners& operator+=(_Callable&& listener) {
+		add(std::forward<_Callable>(listener));
 		return *this;
 	}
 
 	/*
-		Removes a listener from the EventListeners instance that matches the passed function.
+		Removes the listener that was returned by add.
+		Returns whether the listener was found.
+	*/
+	bool remove(EventListenerHandle const handle) {
+		return _modify([&](ContainerType& listeners) {
+			return std::erase_if(listeners, [&](auto const& entry) { return entry->handle == handle; }) > 0;
+		});
+	}
+	/*
+		Removes a listener that has the same type as the passed callable.
+		If the callable type can be compared, like function pointers, the listener also needs to be equal to it.
+		Prefer removing listeners by the handle returned from add.
 		Equivalent to EventListeners::operator-=.
 	*/
-	void remove(std::function<FunctionType> const& listener) {
-		auto const lock = std::scoped_lock{_mutex};
-		auto const& listener_type = listener.target_type();
-		auto const found_position = std::ranges::find_if(_listeners, [&](auto const& listener_element) {
-			// template keyword is used to expicitly tell the compiler that target is a template method for
-			// std::function<FunctionType> and < shouldn't be parsed as the less-than operator
-			return listener_type == listener_element.target_type() &&
-				*(listener.template target<FunctionType>()) == *(listener_element.template target<FunctionType>());
+	template<typename _Callable> requires std::constructible_from<Listener, _Callable>
+	bool remove(_Callable const& listener) {
+		using Target = std::decay_t<_Callable>;
+		return _modify([&](ContainerType& listeners) {
+			auto const found_position = std::ranges::find_if(listeners, [&](auto const& entry) {
+				auto const* const target = entry->listener.template target<Target>();
+				if constexpr (std::equality_comparable<Target>) {
+					return target && *target == listener;
+				}
+				else {
+					return target != nullptr;
+				}
+			});
+			if (found_position == listeners.end()) {
+				return false;
+			}
+			listeners.erase(found_position);
+			return true;
 		});
-		if (found_position != _listeners.end()) {
-			*found_position = std::move(_listeners.back());
-			_listeners.pop_back();
-		}
 	}
 	/*
-		Removes a listener from the EventListeners instance that matches the passed function.
+		Removes a listener from the EventListeners instance that matches the passed function or handle.
 		Equivalent to EventListeners::remove.
 	*/
-	EventListeners& operator-=(std::function<FunctionType> const& listener) {
+	template<typename _Callable> requires 
+		std::constructible_from<Listener, _Callable> || std::same_as<std::remove_cvref_t<_Callable>, EventListenerHandle>
+	EventListeners& operator-=(_Callable const& listener) {
 		remove(listener);
 		return *this;
 	}
@@ -3843,36 +5525,207 @@ public:
 		Calls all of the listeners with event_arguments as arguments.
 		Equivalent to EventListeners::operator().
 	*/
-	void notify_all(_Arguments&& ... event_arguments) {
-		auto const lock = std::scoped_lock{_mutex};
-		for (auto& listener : _listeners) {
-			listener(std::forward<_Arguments>(event_arguments)...);
+	void notify_all(_Arguments&& ... event_arguments) const {
+		if (auto const reader = _SnapshotReader{*this}; reader.listeners) {
+			for (auto const& entry : *reader.listeners) {
+				entry->listener(std::forward<_Arguments>(event_arguments)...);
+			}
 		}
 	}
 	/*
 		Calls all of the listeners with event_arguments as arguments.
 		Equivalent to EventListeners::notify_all.
 	*/
-	void operator()(_Arguments&& ... event_arguments) {
+	void operator()(_Arguments&& ... event_arguments) const {
 		notify_all(std::forward<_Arguments>(event_arguments)...);
 	}
 
+	/*
+		Queues a notification with copies of event_arguments instead of calling the listeners directly.
+		The listeners are called when notify_queued is called, on the thread that calls it.
+		This can be called from any thread without blocking, so that a slow listener can not stall
+		the thread that produces events.
+	*/
+	void post(std::decay_t<_Arguments> ... event_arguments) {
+		_queue.push(QueuedEvent{std::move(event_arguments)...});
+	}
+	/*
+		Calls the listeners for the notifications that have been queued by post, in the order they were posted.
+		If coalescing is enabled, only the most recently posted notification is made and the others are discarded.
+		Only one thread at a time may call this.
+		Returns the number of notifications that were made.
+	*/
+	std::size_t notify_queued() {
+		auto const notify = [this](QueuedEvent& event) {
+			std::apply([this](auto& ... arguments) {
+				notify_all(static_cast<_Arguments&&>(arguments)...);
+			}, event);
+		};
+		if (_is_coalescing_queued) {
+			if (auto event = _queue.consume_newest()) {
+				notify(*event);
+				return 1;
+			}
+			return 0;
+		}
+		return _queue.consume_all(notify);
+	}
+	/*
+		Sets whether notify_queued only makes the most recent queued notification.
+		This is useful for events where only the latest state matters, like resizing or mouse movement.
+	*/
+	void coalesce_queued(bool const is_coalescing) noexcept {
+		_is_coalescing_queued = is_coalescing;
+	}
+	[[nodiscard]]
+	bool coalesce_queued() const noexcept {
+		return _is_coalescing_queued;
+	}
+	[[nodiscard]]
+	bool has_queued() const noexcept {
+		return !_queue.empty();
+	}
+
 	EventListeners() = default;
+	~EventListeners() {
+		_free_snapshots();
+	}
 
-	EventListeners(EventListeners&& other) noexcept :
-		_listeners{std::move(other._listeners)}
-	{}
+	EventListeners(EventListeners&& other) noexcept {
+		*this = std::move(other);
+	}
 	EventListeners(EventListeners const&) = delete;
 
+	/*
+		Neither instance may be notified while it is moved.
+	*/
 	EventListeners& operator=(EventListeners&& other) noexcept {
-		_listeners = std::move(other._listeners);
+		if (this == &other) {
+			return *this;
+		}
+		auto const lock = std::scoped_lock{_mutex, other._mutex};
+		_listeners = std::exchange(other._listeners, {});
+		_last_handle = other._last_handle.load();
+		// The snapshots are not moved, this one is rebuilt from the listeners by the next notification.
+		_free_snapshots();
+		other._free_snapshots();
+		_is_snapshot_outdated = !_listeners.empty();
+		other._is_snapshot_outdated = false;
+		_queue = std::move(other._queue);
+		_is_coalescing_queued = other._is_coalescing_queued.load();
 		return *this;
 	}
 	EventListeners& operator=(EventListeners const&) = delete;
 
 private:
-	std::recursive_mutex _mutex;
+	/*
+		Lets the modifier change the listeners. If it returns true, 
+		the snapshot is replaced before the next notification.
+	*/
+	bool _modify(std::invocable<ContainerType&> auto const& modifier) {
+		auto const lock = std::scoped_lock{_mutex};
+		if (!modifier(_listeners)) {
+			return false;
+		}
+		_is_snapshot_outdated.store(true, std::memory_order::release);
+		_reclaim_snapshots();
+		return true;
+	}
+
+	/*
+		Registers a notification as a reader of the current snapshot for as long as it exists.
+		A reader first increments the reader count of the current epoch, and then loads the snapshot. 
+		A snapshot that has been replaced is only freed when the epoch has moved on 
+		and the reader count of the epoch it was replaced in has reached zero, see _reclaim_snapshots.
+	*/
+	class _SnapshotReader {
+	public:
+		ContainerType const* listeners;
+
+		explicit _SnapshotReader(EventListeners const& owner) :
+			_owner{owner}
+		{
+			if (owner._is_snapshot_outdated.load(std::memory_order::acquire)) {
+				owner._update_snapshot();
+			}
+			while (true) {
+				_epoch = owner._epoch.load(std::memory_order::seq_cst);
+				owner._reader_counts[_epoch & 1].fetch_add(1, std::memory_order::seq_cst);
+				// If the epoch was changed in the meantime, the count may already have been checked.
+				if (owner._epoch.load(std::memory_order::seq_cst) == _epoch) {
+					break;
+				}
+				owner._reader_counts[_epoch & 1].fetch_sub(1, std::memory_order::release);
+			}
+			listeners = owner._snapshot.load(std::memory_order::seq_cst);
+		}
+		~_SnapshotReader() {
+			_owner._reader_counts[_epoch & 1].fetch_sub(1, std::memory_order::release);
+		}
+
+		_SnapshotReader(_SnapshotReader const&) = delete;
+		_SnapshotReader& operator=(_SnapshotReader const&) = delete;
+
+	private:
+		EventListeners const& _owner;
+		std::uint64_t _epoch;
+	};
+
+	/*
+		Only the pointers to the entries are copied, the listeners themselves are shared with the previous snapshot.
+	*/
+	void _update_snapshot() const {
+		auto const lock = std::scoped_lock{_mutex};
+		if (_is_snapshot_outdated.load(std::memory_order::relaxed)) {
+			auto new_snapshot = _listeners.empty() ? nullptr : std::make_unique<ContainerType const>(_listeners);
+			if (auto* const old_snapshot = _snapshot.exchange(new_snapshot.release(), std::memory_order::seq_cst)) {
+				_retired_snapshots.emplace_back(old_snapshot);
+			}
+			_is_snapshot_outdated.store(false, std::memory_order::release);
+		}
+		_reclaim_snapshots();
+	}
+	/*
+		Frees the snapshots that no reader can be using anymore, without waiting for any reader.
+		Snapshots that are retired in one epoch are freed when the readers that entered before 
+		the next epoch began have finished. Must be called with the mutex locked.
+	*/
+	void _reclaim_snapshots() const {
+		auto const epoch = _epoch.load(std::memory_order::relaxed);
+		if (_reader_counts[(epoch - 1) & 1].load(std::memory_order::seq_cst)) {
+			return;
+		}
+		// Every reader that could see these has left the previous epoch.
+		_snapshots_waiting_for_readers.clear();
+		if (!_retired_snapshots.empty()) {
+			_snapshots_waiting_for_readers = std::exchange(_retired_snapshots, {});
+			_epoch.store(epoch + 1, std::memory_order::seq_cst);
+		}
+	}
+	void _free_snapshots() noexcept {
+		delete _snapshot.exchange(nullptr);
+		_retired_snapshots.clear();
+		_snapshots_waiting_for_readers.clear();
+	}
+
+	// Only used when the listeners are changed and when the snapshot is outdated.
+	mutable std::mutex _mutex;
 	ContainerType _listeners;
+	std::atomic<std::uint64_t> _last_handle{};
+
+	mutable std::atomic<bool> _is_snapshot_outdated{};
+	mutable std::atomic<ContainerType const*> _snapshot{};
+
+	// The reader counts are on their own cache lines, so that readers don't contend with the snapshot pointer.
+	struct alignas(64) _ReaderCount : std::atomic<std::size_t> {};
+	mutable std::array<_ReaderCount, 2> _reader_counts{};
+	mutable std::atomic<std::uint64_t> _epoch{};
+	// Protected by the mutex.
+	mutable std::vector<std::unique_ptr<ContainerType const>> _retired_snapshots;
+	mutable std::vector<std::unique_ptr<ContainerType const>> _snapshots_waiting_for_readers;
+
+	utils::MpscQueue<QueuedEvent> _queue;
+	std::atomic<bool> _is_coalescing_queued{};
 };
 
 //------------------------------
@@ -3974,6 +5827,18 @@ struct WindowParameters {
 	Window* parent;
 };
 
+/*
+	The observable state of a window at a single point in time.
+	The state is updated by the event thread of the window and can be read from any thread, see Window::snapshot.
+*/
+struct WindowSnapshot {
+	math::Size<Dip> size;
+	math::Point<Pixels> position;
+	Factor dip_to_pixel_factor{1.f};
+	bool is_open{true};
+	bool has_focus{};
+};
+
 class Window {
 	friend class WindowBuilder;
 	
@@ -3990,8 +5855,27 @@ public:
 	[[nodiscard]]
 	bool is_open() const;
 
+	/*
+		Returns a consistent copy of the state of the window, without locking.
+		Can be called from any thread.
+	*/
+	[[nodiscard]]
+	WindowSnapshot snapshot() const;
+
+	/*
+		Changes to the window are sent to the window system in batches, once per iteration of its event loop.
+		This sends the changes that have been made so far right away.
+	*/
+	void flush();
+
 	[[nodiscard]]
 	std::any native_handle() const;
+	/*
+		Returns the connection to the window system that the window uses, which is a ::Display* with X11.
+		The connection is shared by all windows.
+	*/
+	[[nodiscard]]
+	std::any native_display() const;
 	
 	Window() = delete;
 	~Window(); // = default in .cpp
@@ -4094,20 +5978,20 @@ constexpr auto
 */
 namespace theme_colors {
 
-inline auto const 
-	background = Id::next(),
-	on_background = Id::next(),
+inline constexpr auto 
+	background = "theme_colors::background"_id,
+	on_background = "theme_colors::on_background"_id,
 
-	primary = Id::next(),
-	primary_on_background = Id::next(),
-	on_primary = Id::next(),
+	primary = "theme_colors::primary"_id,
+	primary_on_background = "theme_colors::primary_on_background"_id,
+	on_primary = "theme_colors::on_primary"_id,
 
-	secondary = Id::next(),
-	secondary_on_background = Id::next(),
-	on_secondary = Id::next(),
+	secondary = "theme_colors::secondary"_id,
+	secondary_on_background = "theme_colors::secondary_on_background"_id,
+	on_secondary = "theme_colors::on_secondary"_id,
 
-	selection = Id::next(),
-	shadow = Id::next();
+	selection = "theme_colors::selection"_id,
+	shadow = "theme_colors::shadow"_id;
 
 } // namespace theme_colors
 
@@ -4116,11 +6000,11 @@ inline auto const
 */
 namespace theme_easings {
 
-inline auto const 
-	in = Id::next(),
-	out = Id::next(),
-	in_out = Id::next(),
-	symmetrical_in_out = Id::next();
+inline constexpr auto 
+	in = "theme_easings::in"_id,
+	out = "theme_easings::out"_id,
+	in_out = "theme_easings::in_out"_id,
+	symmetrical_in_out = "theme_easings::symmetrical_in_out"_id;
 
 } // namespace theme_easings
 
@@ -4129,19 +6013,170 @@ inline auto const
 */
 namespace theme_values {
 
-inline auto const 
-	hover_animation_speed = Id::next(),
-	hover_animation_duration = Id::next();
+inline constexpr auto 
+	hover_animation_speed = "theme_values::hover_animation_speed"_id,
+	hover_animation_duration = "theme_values::hover_animation_duration"_id;
 
 } // namespace theme_values
 
+/*
+	The kind of a theme entry, which determines which map of the theme it is stored in.
+*/
+enum class ThemeEntryKind {
+	Color,
+	Easing,
+	Value,
+};
+
+/*
+	Identifies a theme entry that was changed.
+*/
+struct ThemeChange final {
+	ThemeEntryKind kind;
+	Id id;
+
+	[[nodiscard]]
+	constexpr bool operator==(ThemeChange const&) const noexcept = default;
+};
+
+class Theme;
+
+/*
+	The entries of one kind in a theme. They can be read like an IdMap, 
+	but only be changed through the setters of Theme so that every change is versioned.
+*/
+template<typename _Entry>
+class ThemeEntries final {
+public:
+	using ConstIterator = IdMap<_Entry>::ConstIterator;
+
+	[[nodiscard]]
+	ConstIterator begin() const {
+		return _entries.begin();
+	}
+	[[nodiscard]]
+	ConstIterator end() const {
+		return _entries.end();
+	}
+
+	[[nodiscard]]
+	std::size_t size() const noexcept {
+		return _entries.size();
+	}
+	[[nodiscard]]
+	bool empty() const noexcept {
+		return _entries.empty();
+	}
+
+	[[nodiscard]]
+	ConstIterator find(Id const id) const {
+		return _entries.find(id);
+	}
+	[[nodiscard]]
+	bool contains(Id const id) const {
+		return _entries.contains(id);
+	}
+	/*
+		Throws std::out_of_range if there is no entry with the ID.
+	*/
+	[[nodiscard]]
+	_Entry const& at(Id const id) const {
+		return _entries.at(id);
+	}
+
+	[[nodiscard]]
+	bool operator==(ThemeEntries const&) const = default;
+
+	ThemeEntries() = default;
+	ThemeEntries(std::initializer_list<typename IdMap<_Entry>::value_type> const entries) :
+		_entries(entries)
+	{}
+
+private:
+	friend class Theme;
+
+	IdMap<_Entry> _entries;
+};
+
+/*
+	Keeps track of the versions of the entries of a theme and of which entries have been changed.
+	It is only used by Theme, and is a separate object so that Theme can be an aggregate.
+
+	Versions are taken from a counter shared by all themes, so two different themes never have the same version.
+	This way a ThemeEntryCache notices when the theme it is used with has been replaced.
+	The change listeners belong to the object they were added to, they are not copied or moved with the versions.
+*/
+class ThemeVersions final {
+public:
+	using ChangeListeners = EventListeners<void(std::span<ThemeChange const>)>;
+
+	ThemeVersions() = default;
+	ThemeVersions(ThemeVersions const& other) :
+		_state{other._state}
+	{}
+	ThemeVersions(ThemeVersions&& other) noexcept :
+		_state{std::move(other._state)}
+	{}
+	ThemeVersions& operator=(ThemeVersions const& other) {
+		_state = other._state;
+		return *this;
+	}
+	ThemeVersions& operator=(ThemeVersions&& other) noexcept {
+		_state = std::move(other._state);
+		return *this;
+	}
+
+private:
+	friend class Theme;
+
+	[[nodiscard]]
+	static std::uint64_t _next_version() noexcept {
+		static constinit auto last_version = std::atomic<std::uint64_t>{};
+		return last_version.fetch_add(1, std::memory_order::relaxed) + 1;
+	}
+
+	void _increment(ThemeEntryKind const kind, Id const id) {
+		auto& entry_version = _state.entry_versions[static_cast<std::size_t>(kind)][id];
+		if (entry_version <= _state.taken_version) {
+			_state.changes.push_back(ThemeChange{kind, id});
+		}
+		entry_version = _state.version = _next_version();
+	}
+	[[nodiscard]]
+	std::uint64_t _entry_version(ThemeEntryKind const kind, Id const id) const {
+		auto const& versions = _state.entry_versions[static_cast<std::size_t>(kind)];
+		if (auto const position = versions.find(id); position != versions.end()) {
+			return position->second;
+		}
+		return _state.initial_version;
+	}
+
+	struct _State {
+		// The version of the entries that have not been changed.
+		std::uint64_t initial_version = _next_version();
+		std::uint64_t version = initial_version;
+		std::uint64_t taken_version = initial_version;
+		std::array<IdMap<std::uint64_t>, 3> entry_versions;
+		std::vector<ThemeChange> changes;
+	} _state;
+
+	ChangeListeners _change_listeners;
+};
+
 /*
 	A theme consists of different variables that change the look and feel of the parts of the GUI that are using the theme.
 	Can be used for changing and accessing any values, colors and easings.
 	All the default IDs are in ThemeColors, ThemeEasings and ThemeValues.
+
+	The entries are changed through color(), easing() and value(), and every change is versioned. 
+	Every change gives the theme a new version and stores it as the version of the entry.
+	Consumers can cache resolved entries with ThemeEntryCache and only look them up again when the version has moved.
+	The changed entries are also recorded until take_changes() or notify_changes() is called, 
+	so that subscribers can be notified about a batch of changes instead of every single edit.
 */
-struct Theme final {
-	std::unordered_map<Id, Color> colors{
+class Theme final {
+public:
+	ThemeEntries<Color> colors{
 		{theme_colors::background, Color{0xfffefefe}},
 		{theme_colors::on_background, Color{0xff070707}},
 		{theme_colors::primary, Color{0xff6200ea}},
@@ -4153,17 +6188,170 @@ struct Theme final {
 		{theme_colors::selection, Color{0x90488db5}},
 		{theme_colors::shadow, Color{0x68000000}},
 	};
-	std::unordered_map<Id, Easing> easings{
+	ThemeEntries<Easing> easings{
 		{theme_easings::in, Easing{{0.6f, 0.f}, {0.8f, 0.2f}}},
 		{theme_easings::out, Easing{{0.1f, 0.9f}, {0.2f, 1.f}}},
 		{theme_easings::in_out, Easing{{0.4f, 0.f}, {0.f, 1.f}}},
 		{theme_easings::symmetrical_in_out, Easing{{0.6f, 0.f}, {0.4f, 1.f}}},
 	};
-	std::unordered_map<Id, float> values{
+	ThemeEntries<float> values{
 		// 1/frames where frames is the number of frames the animation takes to finish. If it's 0.5, it finishes in 2 frames.
 		{theme_values::hover_animation_speed, 1.f/6.f},
 		{theme_values::hover_animation_duration, 60.f},
 	};
+	ThemeVersions versions{};
+
+	void color(Id const id, Color const color) {
+		_set(colors, id, color);
+	}
+	[[nodiscard]]
+	Color color(Id const id) const {
+		return colors.at(id);
+	}
+
+	void easing(Id const id, Easing const easing) {
+		_set(easings, id, easing);
+	}
+	[[nodiscard]]
+	Easing easing(Id const id) const {
+		return easings.at(id);
+	}
+
+	void value(Id const id, float const value) {
+		_set(values, id, value);
+	}
+	[[nodiscard]]
+	float value(Id const id) const {
+		return values.at(id);
+	}
+
+	/*
+		Returns the entries of type _Entry, which is Color, Easing or float.
+	*/
+	template<typename _Entry>
+	[[nodiscard]]
+	ThemeEntries<_Entry> const& entries() const noexcept {
+		if constexpr (std::same_as<_Entry, Color>) {
+			return colors;
+		}
+		else if constexpr (std::same_as<_Entry, Easing>) {
+			return easings;
+		}
+		else {
+			static_assert(std::same_as<_Entry, float>, "A theme only stores colors, easings and float values.");
+			return values;
+		}
+	}
+	template<typename _Entry>
+	[[nodiscard]]
+	static constexpr ThemeEntryKind entry_kind() noexcept {
+		if constexpr (std::same_as<_Entry, Color>) {
+			return ThemeEntryKind::Color;
+		}
+		else if constexpr (std::same_as<_Entry, Easing>) {
+			return ThemeEntryKind::Easing;
+		}
+		else {
+			static_assert(std::same_as<_Entry, float>, "A theme only stores colors, easings and float values.");
+			return ThemeEntryKind::Value;
+		}
+	}
+
+	/*
+		Returns the version of the whole theme, which is the version of the most recently changed entry.
+		Versions only increase and are never shared between themes that were created separately.
+	*/
+	[[nodiscard]]
+	std::uint64_t version() const noexcept {
+		return versions._state.version;
+	}
+	/*
+		Returns the version of an entry. Entries that have never been changed have the version the theme was created with.
+	*/
+	[[nodiscard]]
+	std::uint64_t version(ThemeEntryKind const kind, Id const id) const {
+		return versions._entry_version(kind, id);
+	}
+
+	/*
+		Returns the entries that have been changed since the last call, each entry only once
+		and in the order they were first changed in.
+	*/
+	[[nodiscard]]
+	std::vector<ThemeChange> take_changes() {
+		versions._state.taken_version = versions._state.version;
+		return std::exchange(versions._state.changes, {});
+	}
+	[[nodiscard]]
+	bool has_changes() const noexcept {
+		return !versions._state.changes.empty();
+	}
+
+	/*
+		Listeners that are notified by notify_changes() with all entries that were changed since the previous notification.
+	*/
+	[[nodiscard]]
+	ThemeVersions::ChangeListeners& change_listeners() noexcept {
+		return versions._change_listeners;
+	}
+	/*
+		Takes the changes and notifies the change listeners about them, if there were any.
+		This is meant to be called once per frame, so that many edits only lead to one notification.
+		Returns whether there were any changes.
+	*/
+	bool notify_changes() {
+		if (!has_changes()) {
+			return false;
+		}
+		auto const changes = take_changes();
+		versions._change_listeners(std::span{changes});
+		return true;
+	}
+
+private:
+	template<typename _Entry>
+	void _set(ThemeEntries<_Entry>& entries, Id const id, _Entry const value) {
+		entries._entries.insert_or_assign(id, value);
+		versions._increment(entry_kind<_Entry>(), id);
+	}
+};
+
+/*
+	Caches an entry of a theme so that it only needs to be looked up again when it has changed.
+	When nothing in the theme has changed since the last call to get(), no lookup is done at all.
+	Since versions are unique across themes, the cache also notices when it is used with a different theme.
+*/
+template<typename _Entry>
+class ThemeEntryCache final {
+public:
+	[[nodiscard]]
+	_Entry const& get(Theme const& theme) {
+		if (theme.version() != _theme_version) {
+			auto const entry_version = theme.version(Theme::entry_kind<_Entry>(), _id);
+			if (entry_version != _entry_version) {
+				_value = theme.entries<_Entry>().at(_id);
+				_entry_version = entry_version;
+			}
+			_theme_version = theme.version();
+		}
+		return _value;
+	}
+
+	[[nodiscard]]
+	Id id() const noexcept {
+		return _id;
+	}
+
+	explicit ThemeEntryCache(Id const id) :
+		_id{id}
+	{}
+
+private:
+	Id _id;
+	// Both versions start out as a value that no theme has, so that the first get() does a lookup.
+	std::uint64_t _theme_version{};
+	std::uint64_t _entry_version{};
+	_Entry _value{};
 };
 
 //------------------------------
@@ -4337,19 +6525,78 @@ public:
 			_remove_from_parent();
 			
 			_parent = &parent;
-			_root = parent._root;
-
 			_add_to_parent();
+
+			if (parent._root != _root) {
+				// The index of this node is dropped if it was the root, so there is nothing to remove the subtree from.
+				_set_root_of_subtree(*parent._root, _root == this ? nullptr : _index(), parent._index());
+				_id_index.reset();
+			}
+		}
+		return *this;
+	}
+	/*
+		Reserves space for a number of children, so that attaching them does not reallocate.
+	*/
+	Node& reserve_children(std::size_t const count) {
+		_children.reserve(count);
+		return *this;
+	}
+	/*
+		Makes all nodes in a range children of this node, in the order of the range.
+		The range can contain nodes or anything that dereferences to a node, like pointers.
+		Space for all of them is reserved up front if the size of the range is known.
+	*/
+	template<std::ranges::input_range _Range> requires 
+		std::same_as<std::ranges::range_reference_t<_Range>, Node&> ||
+		std::same_as<std::iter_reference_t<std::ranges::range_reference_t<_Range>>, Node&>
+	Node& attach_children(_Range&& children) {
+		if constexpr (std::ranges::sized_range<_Range>) {
+			_children.reserve(_children.size() + static_cast<std::size_t>(std::ranges::size(children)));
+		}
+		for (auto&& element : children) {
+			if constexpr (std::same_as<decltype(element), Node&>) {
+				element.parent(*this);
+			}
+			else {
+				(*element).parent(*this);
+			}
 		}
 		return *this;
 	}
+
+	/*
+		Returns the position of this node among the children of its parent, or 0 if it has no parent.
+	*/
+	[[nodiscard]]
+	std::size_t index_in_parent() const noexcept {
+		return _parent ? _index_in_parent : 0;
+	}
+
+	/*
+		Sets whether the children of this node keep their order when one of them is removed.
+		By default, the last child takes the place of a removed child. That is O(1) but changes 
+		the order of the children, which is also their drawing order.
+		Keeping the order makes removing a child linear in the number of children after it.
+	*/
+	Node& keep_child_order(bool const keep_order) noexcept {
+		_keeps_child_order = keep_order;
+		return *this;
+	}
+	[[nodiscard]]
+	bool keeps_child_order() const noexcept {
+		return _keeps_child_order;
+	}
+
 	/*
 		Detaches the node from its parent, making it a root node.
 	*/
 	Node& detach() noexcept {
 		_remove_from_parent();
 		_parent = nullptr;
-		_root = this;
+		if (_root != this) {
+			_set_root_of_subtree(*this, _index(), nullptr);
+		}
 		return *this;
 	}
 
@@ -4357,10 +6604,198 @@ public:
 	Id id() const noexcept {
 		return _id;
 	}
-	Node& id(Id const new_id) noexcept {
-		_id = new_id;
+	Node& id(Id const new_id) {
+		if (auto* const index = _index()) {
+			_remove_from_index(*index);
+			_id = new_id;
+			_add_to_index(*index);
+		}
+		else {
+			_id = new_id;
+		}
+		return *this;
+	}
+
+	/*
+		Creates an index from IDs to the nodes in the tree that this node belongs to.
+		find_node_by_id, find_nodes_by_id and the component versions then use the index 
+		instead of traversing the tree.
+		The index is kept up to date when nodes are added, removed, moved or given new IDs.
+		It belongs to the root node and is removed if the root node is given a parent.
+		Nodes with the invalid ID are not indexed.
+	*/
+	Node& enable_id_index() {
+		if (auto& root = *_root; !root._id_index) {
+			root._id_index = std::make_unique<IdMap<Node*>>();
+			for (auto& node : utils::flatten(root)) {
+				node._add_to_index(*root._id_index);
+			}
+		}
+		return *this;
+	}
+	/*
+		Removes the ID index of the tree that this node belongs to.
+	*/
+	Node& disable_id_index() noexcept {
+		_root->_id_index.reset();
+		return *this;
+	}
+	/*
+		Returns whether the tree that this node belongs to has an ID index.
+	*/
+	[[nodiscard]]
+	bool has_id_index() const noexcept {
+		return _root->_id_index != nullptr;
+	}
+	/*
+		Returns a node in the tree of this node that has the ID, or nullptr if there is no such node.
+		The other nodes with the same ID can be reached through next_indexed_with_same_id, in no particular order.
+		Always returns nullptr if the tree does not have an ID index.
+	*/
+	[[nodiscard]]
+	Node* first_indexed_with_id(Id const id) const {
+		if (auto const* const index = _index()) {
+			if (auto const position = index->find(id); position != index->end()) {
+				return position->second;
+			}
+		}
+		return nullptr;
+	}
+	/*
+		Returns the next node in the ID index of the tree that has the same ID as this node.
+	*/
+	[[nodiscard]]
+	Node* next_indexed_with_same_id() const noexcept {
+		return _next_with_same_id;
+	}
+
+	/*
+		Iterates over the dirty nodes in a subtree in depth-first pre-order, see avo::dirty_nodes.
+		Subtrees without dirty nodes are skipped without being visited.
+		The dirty flag of a node is cleared when the iterator moves past it, and the 
+		dirty descendant flag of a node is cleared when the iterator leaves its subtree.
+		The tree must not be restructured during the iteration.
+	*/
+	class DirtyIterator {
+	public:
+		using value_type = Node;
+		using reference = Node&;
+		using difference_type = std::ptrdiff_t;
+		using iterator_concept = std::input_iterator_tag;
+
+		DirtyIterator& operator++() {
+			_current->_is_dirty = false;
+			_advance_to_dirty();
+			return *this;
+		}
+		void operator++(int) {
+			++*this;
+		}
+
+		[[nodiscard]]
+		Node& operator*() const noexcept {
+			return *_current;
+		}
+
+		[[nodiscard]]
+		bool operator==(std::default_sentinel_t) const noexcept {
+			return !_current;
+		}
+
+		DirtyIterator() = default;
+		explicit DirtyIterator(Node& root) noexcept :
+			_current{&root},
+			_root{&root}
+		{
+			if (!root._is_dirty) {
+				_advance_to_dirty();
+			}
+		}
+
+	private:
+		void _advance_to_dirty() noexcept {
+			do {
+				_current = _next_flagged(_current);
+			} while (_current && !_current->_is_dirty);
+		}
+		/*
+			Returns the next node in pre-order that is either dirty or has dirty descendants.
+		*/
+		[[nodiscard]]
+		Node* _next_flagged(Node* node) const noexcept {
+			if (node->_has_dirty_descendant) {
+				if (auto* const child = _first_flagged_child(*node, 0)) {
+					return child;
+				}
+				// The dirty descendant was moved to another tree.
+				node->_has_dirty_descendant = false;
+			}
+			for (; node != _root; node = node->_parent) {
+				// The next sibling is found through the stored position of the node, without searching for the node.
+				if (auto* const sibling = _first_flagged_child(*node->_parent, node->_index_in_parent + 1)) {
+					return sibling;
+				}
+				node->_parent->_has_dirty_descendant = false;
+			}
+			return nullptr;
+		}
+		/*
+			Returns the first child of a node at or after an index that is either dirty or has dirty descendants.
+			The search for the next child continues from the position of the previous one, so the children
+			of a node are only looked at once during an iteration.
+		*/
+		[[nodiscard]]
+		static Node* _first_flagged_child(Node const& parent, std::size_t index) noexcept {
+			for (; index < parent._children.size(); ++index) {
+				if (auto* const child = parent._children[index]; child->_is_flagged()) {
+					return child;
+				}
+			}
+			return nullptr;
+		}
+
+		Node* _current{};
+		Node* _root{};
+	};
+
+	/*
+		Marks this node as changed, so that it is visited by avo::dirty_nodes.
+		All ancestors are marked as having a dirty descendant, which stops as soon 
+		as an ancestor that already has the mark is reached.
+	*/
+	Node& mark_dirty() noexcept {
+		_is_dirty = true;
+		if (_parent) {
+			_parent->_mark_has_dirty_descendant();
+		}
 		return *this;
 	}
+	[[nodiscard]]
+	bool is_dirty() const noexcept {
+		return _is_dirty;
+	}
+	/*
+		Returns whether any node in the subtree of this node, excluding itself, may be dirty.
+		It can be true without there being any dirty descendants if they have been detached, 
+		until the next avo::dirty_nodes iteration over this subtree.
+	*/
+	[[nodiscard]]
+	bool has_dirty_descendant() const noexcept {
+		return _has_dirty_descendant;
+	}
+
+	/*
+		Returns whether this node is the ancestor or any of its descendants.
+	*/
+	[[nodiscard]]
+	bool is_in_subtree_of(Node const& ancestor) const noexcept {
+		for (auto const* node = this; node; node = node->_parent) {
+			if (node == &ancestor) {
+				return true;
+			}
+		}
+		return false;
+	}
 
 	/*
 		Returns the component associated with this node.
@@ -4386,10 +6821,10 @@ public:
 	template<typename _Component> 
 	Node(Id const id, _Component& component) :
 		_root{this},
+		_component_type{_checked_type_id<_Component>()},
 		_id{id},
 		_component{&component}
 	{}
-	template<typename _Component> 
 	Node(Id const id) :
 		_root{this},
 		_id{id}
@@ -4397,32 +6832,43 @@ public:
 	template<typename _Component> 
 	Node(_Component& component) :
 		_root{this},
+		_component_type{_checked_type_id<_Component>()},
 		_component{&component}
 	{}
 	template<typename _Component> 
 	Node(Node& parent, Id const id, _Component& component) :
 		_root{parent._root},
 		_parent{&parent},
+		_component_type{_checked_type_id<_Component>()},
 		_id{id},
 		_component{&component}
 	{
 		_add_to_parent();
+		if (auto* const index = _index()) {
+			_add_to_index(*index);
+		}
 	}
 	template<typename _Component> 
 	Node(Node& parent, _Component& component) :
 		_root{parent._root},
 		_parent{&parent},
+		_component_type{_checked_type_id<_Component>()},
 		_component{&component}
 	{
 		_add_to_parent();
+		if (auto* const index = _index()) {
+			_add_to_index(*index);
+		}
 	}
-	template<typename _Component> 
 	Node(Node& parent, Id const id) :
 		_root{parent._root},
 		_parent{&parent},
 		_id{id}
 	{
 		_add_to_parent();
+		if (auto* const index = _index()) {
+			_add_to_index(*index);
+		}
 	}
 	~Node() {
 		_remove_from_tree();
@@ -4440,83 +6886,395 @@ public:
 		return *this;
 	}
 
-private:
-	template<typename _Component>
-	_Component* _get_component() const {
-		if (_component.type() == typeid(_Component*)) {
-			return std::any_cast<_Component*>(_component);
+	friend void reparent_all(Node& from, Node& to);
+
+private:
+	template<typename _Component>
+	[[nodiscard]]
+	static utils::TypeId _checked_type_id() {
+		utils::check_type_id<_Component>();
+		return utils::type_id<_Component>;
+	}
+	template<typename _Component>
+	_Component* _get_component() const {
+		if (_component_type == utils::type_id<_Component>) {
+			utils::check_type_id<_Component>();
+			// The component was stored as a _Component*, so the const_cast only restores its original type.
+			return static_cast<_Component*>(const_cast<void*>(_component));
+		}
+		else {
+			return nullptr;
+		}
+	}
+
+	void _remove_from_parent() noexcept {
+		if (!_parent) {
+			return;
+		}
+		auto& siblings = _parent->_children;
+		if (_parent->_keeps_child_order) {
+			siblings.erase(siblings.begin() + static_cast<std::ptrdiff_t>(_index_in_parent));
+			for (auto* const sibling : siblings | std::views::drop(static_cast<std::ptrdiff_t>(_index_in_parent))) {
+				--sibling->_index_in_parent;
+			}
+		}
+		else {
+			auto* const last = siblings.back();
+			last->_index_in_parent = _index_in_parent;
+			siblings[_index_in_parent] = last;
+			siblings.pop_back();
+		}
+	}
+	void _add_to_parent() {
+		if (_parent) {
+			_index_in_parent = _parent->_children.size();
+			_parent->_children.push_back(this);
+			if (_is_flagged()) {
+				_parent->_mark_has_dirty_descendant();
+			}
+		}
+	}
+
+	[[nodiscard]]
+	bool _is_flagged() const noexcept {
+		return _is_dirty || _has_dirty_descendant;
+	}
+	/*
+		If a node has the dirty descendant mark then so do its ancestors, so the marking can stop there.
+	*/
+	void _mark_has_dirty_descendant() noexcept {
+		for (auto* node = this; node && !node->_has_dirty_descendant; node = node->_parent) {
+			node->_has_dirty_descendant = true;
+		}
+	}
+	void _remove_from_tree() noexcept {
+		_remove_from_parent();
+
+		// The index is destroyed if this is the root, so nothing needs to be removed from it.
+		auto* const index = _root == this ? nullptr : _index();
+		if (index) {
+			_remove_from_index(*index);
+		}
+		_id_index.reset();
+
+		for (auto* const child : std::exchange(_children, {})) {
+			child->_parent = nullptr;
+			child->_set_root_of_subtree(*child, index, nullptr);
+		}
+		_parent = nullptr;
+		_root = this;
+	}
+	void _move_construct(Node&& other) noexcept {
+		_root = other._root;
+		if (_root == &other) {
+			_root = this;
+		}
+		
+		if (_parent = other._parent) {
+			_index_in_parent = other._index_in_parent;
+			_parent->_children[_index_in_parent] = this;
+		}
+		_keeps_child_order = other._keeps_child_order;
+		_is_dirty = other._is_dirty;
+		_has_dirty_descendant = other._has_dirty_descendant;
+
+		_children = std::move(other._children);
+		for (auto* const child : _children) {
+			child->_parent = this;
+		}
+		if (_root == this) {
+			for (auto& node : utils::flatten(*this)) {
+				node._root = this;
+			}
+		}
+
+		_id = other._id;
+		_component = other._component;
+		_component_type = other._component_type;
+
+		// Take the place of the other node in the ID index.
+		_id_index = std::move(other._id_index);
+		if (auto* const index = _index(); index && _id != Id{}) {
+			_previous_with_same_id = std::exchange(other._previous_with_same_id, nullptr);
+			_next_with_same_id = std::exchange(other._next_with_same_id, nullptr);
+			(_previous_with_same_id ? _previous_with_same_id->_next_with_same_id : (*index)[_id]) = this;
+			if (_next_with_same_id) {
+				_next_with_same_id->_previous_with_same_id = this;
+			}
+		}
+
+		// The other node is left as an empty root.
+		other._root = &other;
+		other._parent = nullptr;
+		other._children.clear();
+	}
+
+	[[nodiscard]]
+	IdMap<Node*>* _index() const noexcept {
+		return _root->_id_index.get();
+	}
+	/*
+		The nodes with the same ID in an index form a doubly linked list, 
+		and the index maps the ID to the first node in the list.
+		The links of a node are only valid while its root has an index.
+	*/
+	void _add_to_index(IdMap<Node*>& index) {
+		if (_id == Id{}) {
+			return;
+		}
+		auto& first = index[_id];
+		_previous_with_same_id = nullptr;
+		_next_with_same_id = std::exchange(first, this);
+		if (_next_with_same_id) {
+			_next_with_same_id->_previous_with_same_id = this;
+		}
+	}
+	void _remove_from_index(IdMap<Node*>& index) noexcept {
+		if (_id == Id{}) {
+			return;
+		}
+		if (_previous_with_same_id) {
+			_previous_with_same_id->_next_with_same_id = _next_with_same_id;
+		}
+		else if (_next_with_same_id) {
+			index.find(_id)->second = _next_with_same_id;
+		}
+		else {
+			index.erase(_id);
+		}
+		if (_next_with_same_id) {
+			_next_with_same_id->_previous_with_same_id = _previous_with_same_id;
+		}
+		_previous_with_same_id = _next_with_same_id = nullptr;
+	}
+	/*
+		Moves all nodes in the subtree of this node to the tree of another root, and from one index to another.
+	*/
+	void _set_root_of_subtree(Node& root, IdMap<Node*>* const old_index, IdMap<Node*>* const new_index) {
+		for (auto& node : utils::flatten(*this)) {
+			if (old_index) {
+				node._remove_from_index(*old_index);
+			}
+			node._root = &root;
+			if (new_index) {
+				node._add_to_index(*new_index);
+			}
+		}
+	}
+
+	Node* _root{};
+	Node* _parent{};
+	ContainerType _children;
+	// The position of this node in the children of its parent, so that it can be removed without searching.
+	std::size_t _index_in_parent{};
+	bool _keeps_child_order{};
+	bool _is_dirty{};
+	bool _has_dirty_descendant{};
+	/*
+		The component is stored as an untyped pointer together with the ID of its type, 
+		so that component<T>() is a single comparison and no RTTI is needed.
+		The type ID is 32 bits so that it fits in the padding after the flags above, 
+		and is a compile-time constant so that nothing else needs to be loaded for the comparison.
+	*/
+	utils::TypeId _component_type{};
+
+	Id _id{};
+
+	void const* _component{};
+
+	std::unique_ptr<IdMap<Node*>> _id_index;
+	Node* _previous_with_same_id{};
+	Node* _next_with_same_id{};
+};
+
+/*
+	Moves all children of one node to the end of the children of another node, keeping their order.
+	This is linear in the number of children moved, plus the size of their subtrees if they 
+	are moved to another tree.
+	Throws std::invalid_argument if the new parent is a descendant of the old one.
+*/
+inline void reparent_all(Node& from, Node& to) {
+	if (&from == &to) {
+		return;
+	}
+	if (to.is_in_subtree_of(from)) {
+		throw std::invalid_argument{"The children of a node can not be moved into their own subtrees."};
+	}
+
+	auto const is_same_tree = from._root == to._root;
+	auto* const old_index = from._index();
+	auto* const new_index = to._index();
+	auto const first_moved_position = static_cast<std::ptrdiff_t>(to._children.size());
+
+	auto children = std::exchange(from._children, {});
+	if (to._children.empty()) {
+		// The children keep their positions.
+		to._children = std::move(children);
+		for (auto* const child : to._children) {
+			child->_parent = &to;
+			if (child->_is_flagged()) {
+				to._mark_has_dirty_descendant();
+			}
+		}
+	}
+	else {
+		to._children.reserve(to._children.size() + children.size());
+		for (auto* const child : children) {
+			child->_parent = &to;
+			child->_add_to_parent();
+		}
+	}
+
+	if (!is_same_tree) {
+		for (auto* const child : to._children | std::views::drop(first_moved_position)) {
+			child->_set_root_of_subtree(*to._root, old_index, new_index);
+		}
+	}
+}
+
+/*
+	Returns a view over the dirty nodes in the subtree of a node, including the node itself, 
+	and clears their dirty flags as it goes. See Node::mark_dirty and Node::DirtyIterator.
+	Only the changed parts of the tree are visited.
+*/
+[[nodiscard]]
+inline std::ranges::subrange<Node::DirtyIterator, std::default_sentinel_t> dirty_nodes(Node& root) noexcept {
+	return {Node::DirtyIterator{root}, std::default_sentinel};
+}
+
+/*
+	A lazy view of the nodes with an ID within the subtree of a node, including the node itself.
+	Without an ID index, the subtree is traversed in depth-first order.
+	With an ID index, the nodes with the ID are reached through the index instead, in no particular order.
+	No memory is allocated in either case.
+*/
+template<typename _Node> requires std::same_as<std::remove_cvref_t<_Node>, Node>
+class NodesWithIdView : public std::ranges::view_interface<NodesWithIdView<_Node>> {
+public:
+	using TreeIterator = std::ranges::iterator_t<decltype(utils::flatten(std::declval<_Node&>()))>;
+
+	class Iterator {
+	public:
+		using value_type = Node;
+		using reference = _Node&;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+
+		Iterator& operator++() {
+			if (auto* const tree_position = std::get_if<TreeIterator>(&_position)) {
+				++*tree_position;
+				_skip_to_id(*tree_position);
+			}
+			else {
+				_skip_to_subtree(std::get<_Node*>(_position)->next_indexed_with_same_id());
+			}
+			return *this;
 		}
-		else {
-			return nullptr;
+		Iterator operator++(int) {
+			auto previous = *this;
+			++*this;
+			return previous;
 		}
-	}
 
-	void _remove_from_parent() {
-		if (_parent) {
-			utils::unordered_erase(_parent->_children, this);
-		}
-	}
-	void _add_to_parent() {
-		if (_parent) {
-			_parent->_children.push_back(this);
+		[[nodiscard]]
+		reference operator*() const {
+			if (auto* const tree_position = std::get_if<TreeIterator>(&_position)) {
+				return **tree_position;
+			}
+			return *std::get<_Node*>(_position);
 		}
-	}
-	void _remove_from_tree() {
-		_remove_from_parent();
-		if (!_children.empty()) {
-			std::ranges::for_each(_children, &Node::detach);
+
+		[[nodiscard]]
+		bool operator==(std::default_sentinel_t) const noexcept {
+			if (auto* const tree_position = std::get_if<TreeIterator>(&_position)) {
+				return *tree_position == std::default_sentinel;
+			}
+			return std::get<_Node*>(_position) == nullptr;
 		}
-	}
-	void _move_construct(Node&& other) {
-		_root = other._root;
-		if (_root == &other) {
-			_root = this;
+		[[nodiscard]]
+		bool operator==(Iterator const& other) const noexcept {
+			return _position == other._position;
 		}
-		
-		if (_parent = other._parent) {
-			if (auto const previous_child_pos = std::ranges::find(_parent->_children, &other);
-				previous_child_pos != _parent->_children.end()) 
-			{
-				*previous_child_pos = this;
+
+		Iterator() = default;
+		Iterator(_Node& root, Id const id) :
+			_root{&root},
+			_id{id}
+		{
+			if (root.has_id_index() && id != Id{}) {
+				_skip_to_subtree(root.first_indexed_with_id(id));
+			}
+			else {
+				auto tree_position = utils::flatten(root).begin();
+				_skip_to_id(tree_position);
+				_position = tree_position;
 			}
 		}
 
-		_children = std::move(other._children);
-		for (auto* const child : _children) {
-			child->_parent = this;
+	private:
+		void _skip_to_id(TreeIterator& tree_position) const {
+			while (tree_position != std::default_sentinel && (*tree_position).id() != _id) {
+				++tree_position;
+			}
+		}
+		void _skip_to_subtree(Node* node) {
+			while (node && !node->is_in_subtree_of(*_root)) {
+				node = node->next_indexed_with_same_id();
+			}
+			_position = node;
 		}
 
-		_id = other._id;
-		_component = std::move(other._component);
+		_Node* _root{};
+		Id _id{};
+		std::variant<TreeIterator, _Node*> _position;
+	};
+
+	[[nodiscard]]
+	Iterator begin() const {
+		return Iterator{*_root, _id};
+	}
+	[[nodiscard]]
+	std::default_sentinel_t end() const noexcept {
+		return {};
 	}
 
-	Node* _root{};
-	Node* _parent{};
-	ContainerType _children;
+	NodesWithIdView() = default;
+	NodesWithIdView(_Node& root, Id const id) noexcept :
+		_root{&root},
+		_id{id}
+	{}
 
+private:
+	_Node* _root{};
 	Id _id{};
-	std::any _component{};
 };
 
+/*
+	Returns a node with the ID within the subtree of node, including node itself.
+	Without an ID index, the first one in depth-first order is returned.
+	With an ID index, see Node::enable_id_index, any of them may be returned, 
+	which is not necessarily the first one in depth-first order.
+*/
 template<typename _Node> requires std::same_as<std::remove_cvref_t<_Node>, Node>
 [[nodiscard]]
 _Node* find_node_by_id(_Node& node, Id const id) {
-	constexpr auto id_from_node = [](_Node& node){ return node.id(); };
-	auto const flattened = avo::utils::flatten(node);
-	if (auto const pos = std::ranges::find(flattened, id, id_from_node);
-		pos == std::ranges::end(flattened)) 
-	{
-		return nullptr;
-	}
-	else {
-		return &*pos;
+	auto const found_nodes = NodesWithIdView<_Node>{node, id};
+	if (auto const found = found_nodes.begin(); found != found_nodes.end()) {
+		return &*found;
 	}
+	return nullptr;
 }
 
+/*
+	Returns a lazy view of the nodes with the ID within the subtree of node, including node itself.
+	Without an ID index, the nodes are in depth-first order.
+	With an ID index, see Node::enable_id_index, they are in no particular order.
+*/
 template<typename _Node> requires std::same_as<std::remove_cvref_t<_Node>, Node>
 [[nodiscard]]
-std::ranges::view auto find_nodes_by_id(_Node& node, Id const id) {
-	return node | avo::utils::flatten | std::views::filter([=](_Node& node) { return node.id() == id; });
+NodesWithIdView<_Node> find_nodes_by_id(_Node& node, Id const id) {
+	return {node, id};
 }
 
 template<typename _Component>
@@ -4555,4 +7313,385 @@ std::ranges::view auto find_components_by_id(_Node& node, Id const id) {
 		});
 }
 
+//------------------------------
+
+/*
+	Refers to a node in a NodeArena.
+	The generation makes a handle to a destroyed node invalid, even if its slot has been reused by another node.
+	A default constructed handle does not refer to any node.
+*/
+struct NodeHandle final {
+	std::uint32_t index{};
+	std::uint32_t generation{};
+
+	[[nodiscard]]
+	constexpr explicit operator bool() const noexcept {
+		return generation != 0;
+	}
+
+	[[nodiscard]]
+	constexpr bool operator==(NodeHandle const&) const noexcept = default;
+};
+
+/*
+	Stores a tree of nodes with values of type _Value in contiguous chunks of memory, as an alternative to Node.
+	
+	Nodes are referred to by NodeHandle and linked to their parent, first and last child and siblings
+	by their indices, so adding, removing and reparenting a node is O(1) and never moves other nodes.
+	Destroyed slots are reused, but a node's memory is never moved, so references to values stay valid
+	until their nodes are destroyed. Trees that are built in pre-order are also stored in pre-order,
+	so traversing them mostly accesses memory sequentially.
+*/
+template<typename _Value>
+class NodeArena final {
+	static constexpr auto no_index = std::numeric_limits<std::uint32_t>::max();
+	static constexpr auto chunk_size = std::uint32_t{1024};
+
+	struct _Slot {
+		std::optional<_Value> value;
+		std::uint32_t generation{1};
+		std::uint32_t parent{no_index};
+		std::uint32_t first_child{no_index};
+		std::uint32_t last_child{no_index};
+		std::uint32_t previous_sibling{no_index};
+		// For free slots, this is the next free slot.
+		std::uint32_t next_sibling{no_index};
+	};
+
+public:
+	using value_type = _Value;
+
+	/*
+		Iterates the nodes of a subtree in pre-order, following the links without any stack.
+	*/
+	class PreOrderIterator final {
+	public:
+		using value_type = NodeHandle;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+
+		[[nodiscard]]
+		NodeHandle operator*() const noexcept {
+			return _arena->_handle(_index);
+		}
+
+		PreOrderIterator& operator++() noexcept {
+			if (auto const& slot = _arena->_slot(_index); slot.first_child != no_index) {
+				_index = slot.first_child;
+				return *this;
+			}
+			for (auto index = _index; index != _root; index = _arena->_slot(index).parent) {
+				if (auto const next_sibling = _arena->_slot(index).next_sibling; next_sibling != no_index) {
+					_index = next_sibling;
+					return *this;
+				}
+			}
+			_index = no_index;
+			return *this;
+		}
+		PreOrderIterator operator++(int) noexcept {
+			auto previous = *this;
+			++*this;
+			return previous;
+		}
+
+		[[nodiscard]]
+		bool operator==(PreOrderIterator const& other) const noexcept {
+			return _index == other._index;
+		}
+		[[nodiscard]]
+		bool operator==(std::default_sentinel_t) const noexcept {
+			return _index == no_index;
+		}
+
+		PreOrderIterator() = default;
+		PreOrderIterator(NodeArena const& arena, std::uint32_t const root) noexcept :
+			_arena{&arena},
+			_root{root},
+			_index{root}
+		{}
+
+	private:
+		NodeArena const* _arena{};
+		std::uint32_t _root{no_index};
+		std::uint32_t _index{no_index};
+	};
+
+	/*
+		Iterates the children of a node in order.
+	*/
+	class ChildIterator final {
+	public:
+		using value_type = NodeHandle;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+
+		[[nodiscard]]
+		NodeHandle operator*() const noexcept {
+			return _arena->_handle(_index);
+		}
+
+		ChildIterator& operator++() noexcept {
+			_index = _arena->_slot(_index).next_sibling;
+			return *this;
+		}
+		ChildIterator operator++(int) noexcept {
+			auto previous = *this;
+			++*this;
+			return previous;
+		}
+
+		[[nodiscard]]
+		bool operator==(ChildIterator const& other) const noexcept {
+			return _index == other._index;
+		}
+		[[nodiscard]]
+		bool operator==(std::default_sentinel_t) const noexcept {
+			return _index == no_index;
+		}
+
+		ChildIterator() = default;
+		ChildIterator(NodeArena const& arena, std::uint32_t const first_child) noexcept :
+			_arena{&arena},
+			_index{first_child}
+		{}
+
+	private:
+		NodeArena const* _arena{};
+		std::uint32_t _index{no_index};
+	};
+
+	/*
+		Creates a root node.
+	*/
+	NodeHandle create(_Value value) {
+		auto const index = _next_free_slot();
+		// The slot is only taken once the value has been constructed, so it stays free if that throws.
+		auto& slot = _slot(index);
+		slot.value.emplace(std::move(value));
+		_first_free_slot = std::exchange(slot.next_sibling, no_index);
+		++_size;
+		return _handle(index);
+	}
+	/*
+		Creates a node as the last child of parent.
+		Throws std::out_of_range if parent is not a valid handle.
+	*/
+	NodeHandle create(NodeHandle const parent, _Value value) {
+		auto const parent_index = _checked_index(parent);
+		auto const handle = create(std::move(value));
+		_link_as_last_child(handle.index, parent_index);
+		return handle;
+	}
+
+	/*
+		Destroys a node and all of its descendants.
+		Handles to the destroyed nodes become invalid.
+	*/
+	void destroy(NodeHandle const node) {
+		auto const index = _checked_index(node);
+		_unlink(index);
+
+		// The nodes are freed in post-order by always freeing the first leaf below the current node.
+		// A freed node is the first child of its parent, so its next sibling becomes the parent's first child.
+		for (auto current = index;;) {
+			while (_slot(current).first_child != no_index) {
+				current = _slot(current).first_child;
+			}
+			if (current == index) {
+				_free_slot(current);
+				return;
+			}
+			auto const parent = _slot(current).parent;
+			_slot(parent).first_child = _slot(current).next_sibling;
+			_free_slot(current);
+			current = parent;
+		}
+	}
+
+	/*
+		Makes a node the last child of new_parent. 
+		Throws std::invalid_argument if new_parent is the node itself or one of its descendants.
+	*/
+	void reparent(NodeHandle const node, NodeHandle const new_parent) {
+		auto const index = _checked_index(node);
+		auto const parent_index = _checked_index(new_parent);
+		for (auto ancestor = parent_index; ancestor != no_index; ancestor = _slot(ancestor).parent) {
+			if (ancestor == index) {
+				throw std::invalid_argument{"A node can not be made a child of itself or of its descendants."};
+			}
+		}
+		_unlink(index);
+		_link_as_last_child(index, parent_index);
+	}
+	/*
+		Detaches a node from its parent, making it a root node.
+	*/
+	void detach(NodeHandle const node) {
+		_unlink(_checked_index(node));
+	}
+
+	/*
+		Returns whether the handle refers to a node that has not been destroyed.
+	*/
+	[[nodiscard]]
+	bool contains(NodeHandle const node) const noexcept {
+		return node && node.index < _capacity() && 
+			_slot(node.index).generation == node.generation && _slot(node.index).value.has_value();
+	}
+
+	[[nodiscard]]
+	_Value& operator[](NodeHandle const node) noexcept {
+		return *_slot(node.index).value;
+	}
+	[[nodiscard]]
+	_Value const& operator[](NodeHandle const node) const noexcept {
+		return *_slot(node.index).value;
+	}
+	/*
+		Throws std::out_of_range if node is not a valid handle.
+	*/
+	[[nodiscard]]
+	_Value& at(NodeHandle const node) {
+		return *_slot(_checked_index(node)).value;
+	}
+	[[nodiscard]]
+	_Value const& at(NodeHandle const node) const {
+		return *_slot(_checked_index(node)).value;
+	}
+
+	/*
+		Returns the parent of a node, or an empty handle if it is a root.
+	*/
+	[[nodiscard]]
+	NodeHandle parent(NodeHandle const node) const {
+		return _handle(_slot(_checked_index(node)).parent);
+	}
+	[[nodiscard]]
+	NodeHandle first_child(NodeHandle const node) const {
+		return _handle(_slot(_checked_index(node)).first_child);
+	}
+	[[nodiscard]]
+	NodeHandle last_child(NodeHandle const node) const {
+		return _handle(_slot(_checked_index(node)).last_child);
+	}
+	[[nodiscard]]
+	NodeHandle next_sibling(NodeHandle const node) const {
+		return _handle(_slot(_checked_index(node)).next_sibling);
+	}
+	[[nodiscard]]
+	NodeHandle previous_sibling(NodeHandle const node) const {
+		return _handle(_slot(_checked_index(node)).previous_sibling);
+	}
+
+	/*
+		Returns a view of the children of a node.
+	*/
+	[[nodiscard]]
+	std::ranges::subrange<ChildIterator, std::default_sentinel_t> children(NodeHandle const node) const {
+		return {ChildIterator{*this, _slot(_checked_index(node)).first_child}, std::default_sentinel};
+	}
+	/*
+		Returns a view of a node and all of its descendants in pre-order.
+	*/
+	[[nodiscard]]
+	std::ranges::subrange<PreOrderIterator, std::default_sentinel_t> pre_order(NodeHandle const node) const {
+		return {PreOrderIterator{*this, _checked_index(node)}, std::default_sentinel};
+	}
+
+	/*
+		Returns the number of nodes in the arena.
+	*/
+	[[nodiscard]]
+	std::size_t size() const noexcept {
+		return _size;
+	}
+	[[nodiscard]]
+	bool empty() const noexcept {
+		return _size == 0;
+	}
+
+	NodeArena() = default;
+
+private:
+	[[nodiscard]]
+	std::uint32_t _capacity() const noexcept {
+		return static_cast<std::uint32_t>(_chunks.size())*chunk_size;
+	}
+	[[nodiscard]]
+	_Slot& _slot(std::uint32_t const index) noexcept {
+		return _chunks[index/chunk_size][index % chunk_size];
+	}
+	[[nodiscard]]
+	_Slot const& _slot(std::uint32_t const index) const noexcept {
+		return _chunks[index/chunk_size][index % chunk_size];
+	}
+	[[nodiscard]]
+	NodeHandle _handle(std::uint32_t const index) const noexcept {
+		return index == no_index ? NodeHandle{} : NodeHandle{index, _slot(index).generation};
+	}
+	[[nodiscard]]
+	std::uint32_t _checked_index(NodeHandle const node) const {
+		if (!contains(node)) {
+			throw std::out_of_range{"The node handle does not refer to a node in the arena."};
+		}
+		return node.index;
+	}
+
+	/*
+		Returns the first free slot, adding a chunk if there is none. The slot stays in the free list.
+	*/
+	std::uint32_t _next_free_slot() {
+		if (_first_free_slot == no_index) {
+			if (_capacity() >= no_index - chunk_size) {
+				throw std::length_error{"A NodeArena can not hold any more nodes."};
+			}
+			_chunks.push_back(std::make_unique<_Slot[]>(chunk_size));
+			auto const first_new_index = _capacity() - chunk_size;
+			for (auto const index : utils::Range{first_new_index, _capacity() - 2}) {
+				_slot(index).next_sibling = index + 1;
+			}
+			_first_free_slot = first_new_index;
+		}
+		return _first_free_slot;
+	}
+	void _free_slot(std::uint32_t const index) noexcept {
+		auto& slot = _slot(index);
+		slot.value.reset();
+		// Generation 0 is reserved for empty handles.
+		if (++slot.generation == 0) {
+			slot.generation = 1;
+		}
+		slot.parent = slot.first_child = slot.last_child = slot.previous_sibling = no_index;
+		slot.next_sibling = std::exchange(_first_free_slot, index);
+		--_size;
+	}
+
+	void _link_as_last_child(std::uint32_t const index, std::uint32_t const parent_index) noexcept {
+		auto& slot = _slot(index);
+		auto& parent = _slot(parent_index);
+		slot.parent = parent_index;
+		slot.previous_sibling = parent.last_child;
+		slot.next_sibling = no_index;
+		(parent.last_child == no_index ? parent.first_child : _slot(parent.last_child).next_sibling) = index;
+		parent.last_child = index;
+	}
+	void _unlink(std::uint32_t const index) noexcept {
+		auto& slot = _slot(index);
+		if (slot.parent == no_index) {
+			return;
+		}
+		auto& parent = _slot(slot.parent);
+		(slot.previous_sibling == no_index ? parent.first_child : _slot(slot.previous_sibling).next_sibling) = slot.next_sibling;
+		(slot.next_sibling == no_index ? parent.last_child : _slot(slot.next_sibling).previous_sibling) = slot.previous_sibling;
+		slot.parent = slot.previous_sibling = slot.next_sibling = no_index;
+	}
+
+	std::vector<std::unique_ptr<_Slot[]>> _chunks;
+	std::uint32_t _first_free_slot{no_index};
+	std::size_t _size{};
+};
+
 } // namespace avo
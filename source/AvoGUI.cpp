@@ -30,11 +30,25 @@ SOFTWARE.
 
 #ifdef _WIN32
 #	include <windows.h>
-#else
-#	include <iconv.h>
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#	include <immintrin.h>
+#	define AVO_UNICODE_HAS_X86_KERNELS
 #endif
 
 #ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <condition_variable>
+#include <unordered_map>
+
 #include <X11/Xlib.h>
 #include <X11/keysym.h>
 #include <X11/Xutil.h>
@@ -59,12 +73,398 @@ auto enable_utf8_console() -> void {
 	// Pretty much everyone else uses UTF-8 by default.
 }
 
+auto character_count_vectorized(std::string_view const string) noexcept -> std::size_t {
+	auto continuation_bytes = std::size_t{};
+	auto position = std::size_t{};
+#ifdef AVO_UNICODE_HAS_X86_KERNELS
+	// Signed bytes below -64 (0xc0) are continuation bytes.
+	auto const first_non_continuation = _mm_set1_epi8(static_cast<char>(0xc0));
+	// The comparison results are -1 for continuation bytes, so they are subtracted from 8 bit 
+	// counters which are summed up before any of them can overflow.
+	constexpr auto max_chunks_per_sum = std::size_t{255};
+	while (position + 16 <= string.size()) {
+		auto counters = _mm_setzero_si128();
+		for (auto chunk_index = std::size_t{}; 
+			chunk_index < max_chunks_per_sum && position + 16 <= string.size(); 
+			++chunk_index, position += 16) 
+		{
+			auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(string.data() + position));
+			counters = _mm_sub_epi8(counters, _mm_cmplt_epi8(chunk, first_non_continuation));
+		}
+		auto const sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+		continuation_bytes += static_cast<std::size_t>(_mm_cvtsi128_si64(sums)) + 
+			static_cast<std::size_t>(_mm_extract_epi16(sums, 4));
+	}
+#endif
+	for (; position < string.size(); ++position) {
+		continuation_bytes += !is_first_code_point(string[position]);
+	}
+	return string.size() - continuation_bytes;
+}
+
+auto character_count_vectorized(std::u16string_view const string) noexcept -> std::size_t {
+	auto low_surrogates = std::size_t{};
+	auto position = std::size_t{};
+#ifdef AVO_UNICODE_HAS_X86_KERNELS
+	auto const surrogate_mask = _mm_set1_epi16(static_cast<short>(0xfc00));
+	auto const low_surrogate_bits = _mm_set1_epi16(static_cast<short>(0xdc00));
+	// Like for UTF-8, the comparison results are -1 for low surrogates and are subtracted from 
+	// signed 16 bit counters, which are widened to 32 bits and summed up before they can overflow.
+	constexpr auto max_chunks_per_sum = std::size_t{0x3fff};
+	auto sums = _mm_setzero_si128();
+	while (position + 16 <= string.size()) {
+		auto counters = _mm_setzero_si128();
+		for (auto chunk_index = std::size_t{}; 
+			chunk_index < max_chunks_per_sum && position + 16 <= string.size(); 
+			++chunk_index, position += 16) 
+		{
+			auto const first = _mm_loadu_si128(reinterpret_cast<__m128i const*>(string.data() + position));
+			auto const second = _mm_loadu_si128(reinterpret_cast<__m128i const*>(string.data() + position + 8));
+			counters = _mm_sub_epi16(counters, _mm_cmpeq_epi16(_mm_and_si128(first, surrogate_mask), low_surrogate_bits));
+			counters = _mm_sub_epi16(counters, _mm_cmpeq_epi16(_mm_and_si128(second, surrogate_mask), low_surrogate_bits));
+		}
+		sums = _mm_add_epi32(sums, _mm_madd_epi16(counters, _mm_set1_epi16(1)));
+	}
+	auto sum_lanes = std::array<std::uint32_t, 4>{};
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(sum_lanes.data()), sums);
+	low_surrogates = std::accumulate(sum_lanes.begin(), sum_lanes.end(), std::size_t{});
+#endif
+	for (; position < string.size(); ++position) {
+		low_surrogates += !is_first_code_point(string[position]);
+	}
+	return string.size() - low_surrogates;
+}
+
+/*
+	Every character takes one UTF-16 code unit except for those encoded with four 
+	UTF-8 code units, which take two. So the UTF-16 length is the number of bytes 
+	that are not continuation bytes, plus the number of four byte lead bytes.
+*/
+[[nodiscard]]
+constexpr std::size_t utf16_length_of_code_unit(char const code_unit) noexcept {
+	return is_first_code_point(code_unit) + (static_cast<unsigned char>(code_unit) >= 0xf0);
+}
+
+/*
+	Code points below U+0080 take one UTF-8 code unit, below U+0800 two and otherwise three, 
+	except for surrogate pairs which take four together.
+*/
+[[nodiscard]]
+constexpr std::size_t utf8_length_of_code_unit(char16_t const code_unit) noexcept {
+	if ((code_unit & 0xf800) == 0xd800) {
+		return 2;
+	}
+	return std::size_t{1} + (code_unit >= 0x80) + (code_unit >= 0x800);
+}
+
+auto utf16_length_of(std::string_view const input) noexcept -> std::size_t {
+	auto length = std::size_t{};
+	auto position = std::size_t{};
+#ifdef AVO_UNICODE_HAS_X86_KERNELS
+	// Signed bytes below -64 (0xc0) are continuation bytes, unsigned bytes of at least 0xf0 are four byte lead bytes.
+	auto const first_non_continuation = _mm_set1_epi8(static_cast<char>(0xc0));
+	auto const first_four_byte_lead = _mm_set1_epi8(static_cast<char>(0xf0));
+	for (; position + 16 <= input.size(); position += 16) {
+		auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input.data() + position));
+		auto const continuation_bytes = _mm_movemask_epi8(_mm_cmplt_epi8(chunk, first_non_continuation));
+		auto const four_byte_leads = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, first_four_byte_lead), chunk));
+		length += 16 - static_cast<std::size_t>(std::popcount(static_cast<unsigned>(continuation_bytes))) + 
+			static_cast<std::size_t>(std::popcount(static_cast<unsigned>(four_byte_leads)));
+	}
+#endif
+	for (; position < input.size(); ++position) {
+		length += utf16_length_of_code_unit(input[position]);
+	}
+	return length;
+}
+
+auto utf8_length_of(std::u16string_view const input) noexcept -> std::size_t {
+	auto length = std::size_t{};
+	auto position = std::size_t{};
+#ifdef AVO_UNICODE_HAS_X86_KERNELS
+	// SSE2 only has signed 16 bit comparisons, so the sign bit is flipped to compare unsigned values.
+	auto const sign_bit = _mm_set1_epi16(static_cast<short>(0x8000));
+	auto const last_one_unit = _mm_set1_epi16(static_cast<short>(0x7f ^ 0x8000));
+	auto const last_two_units = _mm_set1_epi16(static_cast<short>(0x7ff ^ 0x8000));
+	auto const surrogate_mask = _mm_set1_epi16(static_cast<short>(0xf800));
+	auto const surrogate_bits = _mm_set1_epi16(static_cast<short>(0xd800));
+	for (; position + 8 <= input.size(); position += 8) {
+		auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input.data() + position));
+		auto const flipped = _mm_xor_si128(chunk, sign_bit);
+		// Every 16 bit lane gives two bits in the movemask.
+		auto const count_lanes = [](__m128i const mask) {
+			return static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm_movemask_epi8(mask))))/2;
+		};
+		length += 8 + 
+			count_lanes(_mm_cmpgt_epi16(flipped, last_one_unit)) + 
+			count_lanes(_mm_cmpgt_epi16(flipped, last_two_units)) - 
+			count_lanes(_mm_cmpeq_epi16(_mm_and_si128(chunk, surrogate_mask), surrogate_bits));
+	}
+#endif
+	for (; position < input.size(); ++position) {
+		length += utf8_length_of_code_unit(input[position]);
+	}
+	return length;
+}
+
 #ifndef _WIN32
-using IconvHandle = utils::UniqueHandle<iconv_t, decltype([](iconv_t const handle){iconv_close(handle);})>;
+/*
+	The native transcoder below is used instead of iconv. Most strings in a GUI are ASCII,
+	so runs of ASCII characters are converted in blocks by a SIMD kernel which is selected 
+	at runtime. Everything else goes through a validating scalar decoder that rejects the 
+	same malformed input as iconv does: invalid lead bytes, truncated or overlong sequences, 
+	encoded surrogates, code points above U+10FFFF and unpaired UTF-16 surrogates.
+*/
+
+/*
+	Converts the longest prefix of whole blocks of ASCII characters and returns the number 
+	of code units that were converted. Both input and output have room for size code units.
+*/
+using Utf8ToUtf16AsciiKernel = std::size_t(*)(char const* input, std::size_t size, char16_t* output) noexcept;
+using Utf16ToUtf8AsciiKernel = std::size_t(*)(char16_t const* input, std::size_t size, char* output) noexcept;
+
+#ifdef AVO_UNICODE_HAS_X86_KERNELS
+std::size_t convert_ascii_utf8_to_utf16_sse2(char const* const input, std::size_t const size, char16_t* const output) noexcept {
+	auto const zero = _mm_setzero_si128();
+	auto position = std::size_t{};
+	for (; position + 16 <= size; position += 16) {
+		auto const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + position));
+		if (_mm_movemask_epi8(chunk)) {
+			break;
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output + position), _mm_unpacklo_epi8(chunk, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output + position + 8), _mm_unpackhi_epi8(chunk, zero));
+	}
+	return position;
+}
+std::size_t convert_ascii_utf16_to_utf8_sse2(char16_t const* const input, std::size_t const size, char* const output) noexcept {
+	auto const non_ascii_mask = _mm_set1_epi16(static_cast<short>(0xff80));
+	auto position = std::size_t{};
+	for (; position + 16 <= size; position += 16) {
+		auto const first = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + position));
+		auto const second = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input + position + 8));
+		auto const non_ascii_bits = _mm_and_si128(_mm_or_si128(first, second), non_ascii_mask);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii_bits, _mm_setzero_si128())) != 0xffff) {
+			break;
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output + position), _mm_packus_epi16(first, second));
+	}
+	return position;
+}
+
+[[gnu::target("avx2")]]
+std::size_t convert_ascii_utf8_to_utf16_avx2(char const* const input, std::size_t const size, char16_t* const output) noexcept {
+	auto position = std::size_t{};
+	for (; position + 32 <= size; position += 32) {
+		auto const chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input + position));
+		if (_mm256_movemask_epi8(chunk)) {
+			break;
+		}
+		_mm256_storeu_si256(
+			reinterpret_cast<__m256i*>(output + position), 
+			_mm256_cvtepu8_epi16(_mm256_castsi256_si128(chunk))
+		);
+		_mm256_storeu_si256(
+			reinterpret_cast<__m256i*>(output + position + 16), 
+			_mm256_cvtepu8_epi16(_mm256_extracti128_si256(chunk, 1))
+		);
+	}
+	return position + convert_ascii_utf8_to_utf16_sse2(input + position, size - position, output + position);
+}
+[[gnu::target("avx2")]]
+std::size_t convert_ascii_utf16_to_utf8_avx2(char16_t const* const input, std::size_t const size, char* const output) noexcept {
+	auto const non_ascii_mask = _mm256_set1_epi16(static_cast<short>(0xff80));
+	auto position = std::size_t{};
+	for (; position + 32 <= size; position += 32) {
+		auto const first = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input + position));
+		auto const second = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input + position + 16));
+		if (!_mm256_testz_si256(_mm256_or_si256(first, second), non_ascii_mask)) {
+			break;
+		}
+		// The packing is done within each 128 bit lane, so the 64 bit quarters need to be reordered.
+		auto const packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0b11'01'10'00);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + position), packed);
+	}
+	return position + convert_ascii_utf16_to_utf8_sse2(input + position, size - position, output + position);
+}
+#else
+/*
+	Without SIMD kernels, ASCII characters are converted one by one by the caller.
+*/
+std::size_t convert_ascii_utf8_to_utf16_scalar(char const*, std::size_t, char16_t*) noexcept {
+	return 0;
+}
+std::size_t convert_ascii_utf16_to_utf8_scalar(char16_t const*, std::size_t, char*) noexcept {
+	return 0;
+}
+#endif // AVO_UNICODE_HAS_X86_KERNELS
+
+struct AsciiKernels {
+	Utf8ToUtf16AsciiKernel utf8_to_utf16;
+	Utf16ToUtf8AsciiKernel utf16_to_utf8;
+};
+
+[[nodiscard]]
+AsciiKernels const& get_ascii_kernels() noexcept {
+	static auto const kernels = []() -> AsciiKernels {
+#ifdef AVO_UNICODE_HAS_X86_KERNELS
+		if (__builtin_cpu_supports("avx2")) {
+			return {convert_ascii_utf8_to_utf16_avx2, convert_ascii_utf16_to_utf8_avx2};
+		}
+		return {convert_ascii_utf8_to_utf16_sse2, convert_ascii_utf16_to_utf8_sse2};
+#else
+		return {convert_ascii_utf8_to_utf16_scalar, convert_ascii_utf16_to_utf8_scalar};
 #endif
+	}();
+	return kernels;
+}
+
+/*
+	Decodes the UTF-8 encoded character at the start of input into code_point.
+	Returns the number of code units the character was encoded with,
+	or 0 if the character is malformed.
+*/
+[[nodiscard]]
+inline std::size_t decode_utf8_character(std::string_view const input, char32_t& code_point) noexcept {
+	auto const length = code_point_count(input[0]);
+	if (length <= 0 || static_cast<std::size_t>(length) > input.size()) {
+		return 0;
+	}
+	
+	constexpr auto lead_masks = std::array<unsigned char, 5>{0, 0x7f, 0x1f, 0x0f, 0x07};
+	code_point = static_cast<char32_t>(static_cast<unsigned char>(input[0]) & lead_masks[length]);
+	for (auto i = 1; i < length; ++i) {
+		if (is_first_code_point(input[i])) {
+			return 0;
+		}
+		code_point = code_point << 6 | static_cast<char32_t>(input[i] & 0x3f);
+	}
+
+	constexpr auto smallest_code_points = std::array<char32_t, 5>{0, 0, 0x80, 0x800, 0x10000};
+	if (code_point < smallest_code_points[length] || code_point > 0x10ffff || 
+		code_point >= 0xd800 && code_point <= 0xdfff) 
+	{
+		return 0;
+	}
+	return static_cast<std::size_t>(length);
+}
 
 auto utf8_to_utf16(std::string_view const input, std::span<char16_t> const output) -> std::optional<std::size_t> {
+	auto const convert_ascii = get_ascii_kernels().utf8_to_utf16;
+
+	auto in = std::size_t{};
+	auto out = std::size_t{};
+	while (in < input.size()) {
+		if (!(input[in] & 0x80)) {
+			auto const ascii_length = input.size() - in < 16 ? 0 : convert_ascii(
+				input.data() + in, 
+				std::min(input.size() - in, output.size() - out), 
+				output.data() + out
+			);
+			in += ascii_length;
+			out += ascii_length;
+			
+			for (; in < input.size() && !(input[in] & 0x80); ++in, ++out) {
+				if (out == output.size()) {
+					return {};
+				}
+				output[out] = static_cast<char16_t>(input[in]);
+			}
+			continue;
+		}
+
+		auto code_point = char32_t{};
+		if (auto const length = decode_utf8_character(input.substr(in), code_point)) {
+			in += length;
+		}
+		else {
+			return {};
+		}
+		
+		if (code_point < 0x10000) {
+			if (out == output.size()) {
+				return {};
+			}
+			output[out++] = static_cast<char16_t>(code_point);
+		}
+		else {
+			if (output.size() - out < 2) {
+				return {};
+			}
+			output[out++] = static_cast<char16_t>(0xd800 + ((code_point - 0x10000) >> 10));
+			output[out++] = static_cast<char16_t>(0xdc00 + ((code_point - 0x10000) & 0x3ff));
+		}
+	}
+	return out;
+}
+
+auto utf16_to_utf8(std::u16string_view const input, std::span<char> const output) -> std::optional<std::size_t> {
+	auto const convert_ascii = get_ascii_kernels().utf16_to_utf8;
+
+	auto in = std::size_t{};
+	auto out = std::size_t{};
+	while (in < input.size()) {
+		if (input[in] < 0x80) {
+			auto const ascii_length = input.size() - in < 16 ? 0 : convert_ascii(
+				input.data() + in, 
+				std::min(input.size() - in, output.size() - out), 
+				output.data() + out
+			);
+			in += ascii_length;
+			out += ascii_length;
+
+			for (; in < input.size() && input[in] < 0x80; ++in, ++out) {
+				if (out == output.size()) {
+					return {};
+				}
+				output[out] = static_cast<char>(input[in]);
+			}
+			continue;
+		}
+
+		auto code_point = static_cast<char32_t>(input[in]);
+		switch (code_point_count(input[in])) {
+			case 1:
+				++in;
+				break;
+			case 2:
+				if (in + 1 == input.size() || code_point_count(input[in + 1]) != 0) {
+					return {};
+				}
+				code_point = 0x10000 + ((code_point - 0xd800) << 10 | (input[in + 1] - 0xdc00u));
+				in += 2;
+				break;
+			default:
+				return {};
+		}
+
+		auto const write = [&](std::initializer_list<char32_t> const units) {
+			if (output.size() - out < units.size()) {
+				return false;
+			}
+			for (auto const unit : units) {
+				output[out++] = static_cast<char>(unit);
+			}
+			return true;
+		};
+		auto const was_written = code_point < 0x800 ? 
+			write({0xc0 | code_point >> 6, 0x80 | (code_point & 0x3f)}) :
+			code_point < 0x10000 ? 
+			write({0xe0 | code_point >> 12, 0x80 | (code_point >> 6 & 0x3f), 0x80 | (code_point & 0x3f)}) :
+			write({
+				0xf0 | code_point >> 18, 0x80 | (code_point >> 12 & 0x3f), 
+				0x80 | (code_point >> 6 & 0x3f), 0x80 | (code_point & 0x3f)
+			});
+		if (!was_written) {
+			return {};
+		}
+	}
+	return out;
+}
+#endif
+
 #ifdef _WIN32
+auto utf8_to_utf16(std::string_view const input, std::span<char16_t> const output) -> std::optional<std::size_t> {
 	auto const length = MultiByteToWideChar(
 		CP_UTF8, 0,
 		input.data(), static_cast<int>(input.size()),
@@ -75,29 +475,8 @@ auto utf8_to_utf16(std::string_view const input, std::span<char16_t> const outpu
 		return {};
 	}
 	return length;
-#else
-	// I have no idea why the input string data parameter isn't char const**.
-	// It shouldn't be modified, so a const_cast is made here.
-
-	auto in_pointer = const_cast<char*>(input.data());
-	auto in_bytes_left = input.size();
-	auto out_pointer = reinterpret_cast<char*>(output.data());
-	auto out_bytes_left = output.size()*sizeof(char16_t);
-
-	if (iconv(
-			IconvHandle{iconv_open("UTF-16LE", "UTF-8")}.get(), 
-			&in_pointer, 
-			&in_bytes_left, 
-			&out_pointer, 
-			&out_bytes_left
-		) == static_cast<std::size_t>(-1)) 
-	{
-		return {};
-	}
-	
-	return output.size() - out_bytes_left/sizeof(char16_t);
-#endif
 }
+#endif
 auto utf8_to_utf16(std::string_view const input) -> std::u16string {
 #ifdef _WIN32
 	auto result = std::u16string(MultiByteToWideChar(
@@ -114,18 +493,16 @@ auto utf8_to_utf16(std::string_view const input) -> std::u16string {
 
 	return result;
 #else
-	auto output = std::u16string(input.size(), u'\0');
-	if (auto const length = utf8_to_utf16(input, std::span{output})) {
-		// length includes null terminator because of std::span constructor.
-		output.resize(*length);
+	auto output = std::u16string(utf16_length_of(input), u'\0');
+	if (utf8_to_utf16(input, output)) {
 		return output;
 	}
 	return {};
 #endif
 }
 
-auto utf16_to_utf8(std::u16string_view const input, std::span<char> const output) -> std::optional<std::size_t> {
 #ifdef _WIN32
+auto utf16_to_utf8(std::u16string_view const input, std::span<char> const output) -> std::optional<std::size_t> {
 	auto const length = WideCharToMultiByte(
 		CP_UTF8, 0,
 		reinterpret_cast<wchar_t const*>(input.data()), static_cast<int>(input.size()),
@@ -136,25 +513,8 @@ auto utf16_to_utf8(std::u16string_view const input, std::span<char> const output
 		return {};
 	}
 	return length;
-#else
-	auto in_pointer = const_cast<char*>(reinterpret_cast<char const*>(input.data()));
-	auto in_bytes_left = input.size()*sizeof(char16_t);
-	auto out_pointer = output.data();
-	auto out_bytes_left = output.size();
-
-	if (iconv(
-			IconvHandle{iconv_open("UTF-8", "UTF-16")}.get(), 
-			&in_pointer, 
-			&in_bytes_left, 
-			&out_pointer, 
-			&out_bytes_left
-		) == static_cast<std::size_t>(-1)) 
-	{
-		return {};
-	}
-	return output.size() - out_bytes_left;
-#endif
 }
+#endif
 auto utf16_to_utf8(std::u16string_view const input) -> std::string {
 #ifdef _WIN32
 	auto result = std::string(WideCharToMultiByte(
@@ -172,9 +532,8 @@ auto utf16_to_utf8(std::u16string_view const input) -> std::string {
 
 	return result;
 #else
-	auto output = std::string(input.size()*3, '\0');
-	if (auto const length = utf16_to_utf8(input, std::span{output})) {
-		output.resize(*length);
+	auto output = std::string(utf8_length_of(input), '\0');
+	if (utf16_to_utf8(input, output)) {
 		return output;
 	}
 	return {};
@@ -183,6 +542,50 @@ auto utf16_to_utf8(std::u16string_view const input) -> std::string {
 
 } // namespace unicode
 
+namespace utils {
+
+#ifdef __linux__
+using FileDescriptor = UniqueHandle<int, decltype([](int const descriptor) { ::close(descriptor); }), -1>;
+#endif
+
+MappedFile::MappedFile(std::string const& path, FileAccessPattern const access_pattern) {
+#ifdef __linux__
+	// The mapping stays valid after the file descriptor is closed.
+	if (auto const file = FileDescriptor{::open(path.c_str(), O_RDONLY | O_CLOEXEC)}) {
+		struct stat file_status;
+		if (::fstat(file.get(), &file_status) == 0 && S_ISREG(file_status.st_mode) && file_status.st_size > 0) {
+			auto const size = static_cast<std::size_t>(file_status.st_size);
+			if (auto* const address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.get(), 0); 
+				address != MAP_FAILED) 
+			{
+				if (access_pattern == FileAccessPattern::Sequential) {
+					::madvise(address, size, MADV_SEQUENTIAL);
+				}
+				else if (access_pattern == FileAccessPattern::Random) {
+					::madvise(address, size, MADV_RANDOM);
+				}
+				_mapping = _Mapping{static_cast<std::byte const*>(address), size};
+				return;
+			}
+		}
+	}
+#else
+	static_cast<void>(access_pattern);
+#endif
+	_fallback_data = read_file(path);
+}
+
+void MappedFile::_Unmap::operator()(_Mapping const mapping) const noexcept {
+#ifdef __linux__
+	// munmap takes a non-const pointer, but the pages are unmapped and not written to.
+	::munmap(const_cast<std::byte*>(mapping.address), mapping.size);
+#else
+	static_cast<void>(mapping);
+#endif
+}
+
+} // namespace utils
+
 #ifdef _WIN32
 class Window::Implementation {
 public:
@@ -228,9 +631,13 @@ public:
 		other._server = nullptr;
 	}
 	DisplayResourceHandle& operator=(DisplayResourceHandle&& other) noexcept {
-		_server = other._server;
-		_value = other._value;
-		other._server = nullptr;
+		if (this != &other) {
+			if (_server) {
+				_Deleter{}(_server, _value);
+			}
+			_server = std::exchange(other._server, nullptr);
+			_value = other._value;
+		}
 		return *this;
 	}
 
@@ -297,12 +704,37 @@ math::Size<Pixels> get_screen_size(::Display* const display) noexcept {
 
 //------------------------------
 
-void set_window_title(::Display* const server, ::Window const window, std::string_view const title) noexcept {
+/*
+	The atoms that are used with a display connection.
+	Interning an atom is a round trip to the server, so they are all interned at once when the connection is opened.
+*/
+struct Atoms {
+	::Atom utf8_string;
+	::Atom wm_protocols;
+	::Atom wm_delete_window;
+};
+
+[[nodiscard]]
+Atoms intern_atoms(::Display* const server) noexcept {
+	auto names = std::array{"UTF8_STRING", "WM_PROTOCOLS", "WM_DELETE_WINDOW"};
+	auto atoms = std::array<::Atom, names.size()>{};
+	// XInternAtoms does not modify the names.
+	::XInternAtoms(server, const_cast<char**>(names.data()), static_cast<int>(names.size()), false, atoms.data());
+	return {
+		.utf8_string = atoms[0],
+		.wm_protocols = atoms[1],
+		.wm_delete_window = atoms[2],
+	};
+}
+
+//------------------------------
+
+void set_window_title(::Display* const server, Atoms const& atoms, ::Window const window, std::string_view const title) noexcept {
 	auto text_property = ::XTextProperty{
 		// It's not going to modify the value.
 		.value = const_cast<unsigned char*>(reinterpret_cast<unsigned char const*>(title.data())),
 		#ifdef X_HAVE_UTF8_STRING
-		.encoding = ::XInternAtom(server, "UTF8_STRING", 0),
+		.encoding = atoms.utf8_string,
 		#else
 		.encoding = XA_STRING,
 		#endif
@@ -312,10 +744,11 @@ void set_window_title(::Display* const server, ::Window const window, std::strin
 	
 	::XSetWMName(server, window, &text_property);
 	::XSetWMIconName(server, window, &text_property);
-
-	::XFlush(server);
 }
 
+/*
+	Waits for a reply from the server, so it must be called through DisplayConnection::round_trip.
+*/
 [[nodiscard]]
 std::string get_window_title(::Display* const server, ::Window const window) {
 	::XTextProperty text_property;
@@ -328,6 +761,9 @@ std::string get_window_title(::Display* const server, ::Window const window) {
 
 //------------------------------
 
+/*
+	Waits for a reply from the server, so it must be called through DisplayConnection::round_trip.
+*/
 math::Point<Pixels> get_window_position(::Display* const server, ::Window const window) noexcept {
 	math::Point<Pixels> result;
 	::Window child;
@@ -335,12 +771,252 @@ math::Point<Pixels> get_window_position(::Display* const server, ::Window const
 	return result;
 }
 
+//------------------------------
+
+[[nodiscard]]
+DisplayHandle open_display() {
+	// Xlib must be made thread safe before any other call, since events are read on their own thread.
+	::XInitThreads();
+	auto display = DisplayHandle{::XOpenDisplay(nullptr)};
+	if (!display) {
+		throw std::runtime_error{"Could not open a connection to the X server."};
+	}
+	return display;
+}
+
+/*
+	A connection to the X server that is shared by all windows in the process, together with 
+	everything that only depends on the connection: atoms, the visual and colormap, the input method 
+	and the DIP to pixel factor. A single event thread reads the events of all windows and 
+	dispatches them to the handler of the window they belong to.
+	The connection is closed when the last window that uses it is destroyed.
+*/
+class DisplayConnection {
+public:
+	using EventHandler = utils::InplaceFunction<void(::XEvent const&)>;
+
+	/*
+		Returns the connection that is used by all windows, opening it if there is none.
+	*/
+	[[nodiscard]]
+	static std::shared_ptr<DisplayConnection> shared() {
+		static auto mutex = std::mutex{};
+		static auto weak_connection = std::weak_ptr<DisplayConnection>{};
+
+		auto const lock = std::scoped_lock{mutex};
+		auto connection = weak_connection.lock();
+		if (!connection) {
+			connection = std::make_shared<DisplayConnection>();
+			weak_connection = connection;
+		}
+		return connection;
+	}
+
+	[[nodiscard]]
+	::Display* server() const noexcept {
+		return _server.get();
+	}
+	[[nodiscard]]
+	Atoms const& atoms() const noexcept {
+		return _atoms;
+	}
+	[[nodiscard]]
+	::XVisualInfo const& visual_info() const noexcept {
+		return *_visual_info;
+	}
+	[[nodiscard]]
+	::Colormap colormap() const noexcept {
+		return _colormap.get();
+	}
+	[[nodiscard]]
+	XIM input_method() const noexcept {
+		return _input_method.get();
+	}
+	[[nodiscard]]
+	Factor dip_to_pixel_factor() const noexcept {
+		return _dip_to_pixel_factor;
+	}
+
+	/*
+		The handler is called on the event thread for every event of the window, 
+		until remove_window returns.
+		Handlers are called without any lock held, so they may add and remove windows.
+		They must not destroy the last window though, since the event thread would then have to join itself.
+	*/
+	void add_window(::Window const window, EventHandler handler) {
+		auto const lock = std::scoped_lock{_windows_mutex};
+		_windows[window] = std::move(handler);
+	}
+	void remove_window(::Window const window) {
+		auto lock = std::unique_lock{_windows_mutex};
+		_windows.erase(window);
+		// A handler that removes a window on the event thread is not waited for, since that would never finish.
+		if (std::this_thread::get_id() != _thread.get_id()) {
+			_dispatch_finished.wait(lock, [&] { return _dispatched_window != window; });
+		}
+	}
+
+	/*
+		Requests are buffered by Xlib and sent by the event loop, which flushes once per iteration.
+		Only the first request after a flush wakes the event loop, so a series of 
+		changes made in the same frame is sent to the server together.
+	*/
+	void request_flush() noexcept {
+		if (!_has_unflushed_requests.exchange(true, std::memory_order::relaxed)) {
+			_wake_event_loop();
+		}
+	}
+	/*
+		Sends all requests that have been made so far to the X server right away.
+	*/
+	void flush() noexcept {
+		_has_unflushed_requests.store(false, std::memory_order::relaxed);
+		::XFlush(_server.get());
+	}
+	/*
+		Makes requests that wait for a reply from the X server, like get_window_title and get_window_position, 
+		and returns what the request function returns. All round trips after the connection has been opened must go through here.
+		While Xlib waits for the reply it reads any events that arrive into its queue. The event loop may 
+		already have found the queue empty and be sleeping in poll, which those events would not wake up, 
+		so it is woken if there are queued events after the reply.
+	*/
+	decltype(auto) round_trip(std::invocable<::Display*> auto const& request) {
+		auto const wake_if_events_were_read = utils::Cleanup{[this] {
+			if (::XEventsQueued(_server.get(), QueuedAlready) > 0) {
+				_wake_event_loop();
+			}
+		}};
+		return request(_server.get());
+	}
+
+	DisplayConnection() :
+		_server{open_display()},
+		_atoms{intern_atoms(_server.get())},
+		_visual_info{select_opengl_visual(_server.get())},
+		_colormap{
+			_server.get(), 
+			::XCreateColormap(_server.get(), RootWindow(_server.get(), _visual_info->screen), _visual_info->visual, 0)
+		},
+		_input_method{::XOpenIM(_server.get(), nullptr, nullptr, nullptr)},
+		_dip_to_pixel_factor{calculate_dip_to_pixel_factor(_server.get())}
+	{
+		_thread = std::jthread{[this](std::stop_token const stop_token) {
+			_run_event_loop(stop_token);
+		}};
+	}
+
+	DisplayConnection(DisplayConnection const&) = delete;
+	DisplayConnection& operator=(DisplayConnection const&) = delete;
+
+private:
+	/*
+		Makes the event loop thread return from poll, even if there are no X events.
+	*/
+	void _wake_event_loop() const noexcept {
+		auto const count = std::uint64_t{1};
+		static_cast<void>(::write(_wakeup_event.get(), &count, sizeof(count)));
+	}
+
+	/*
+		The event loop sleeps in poll on both the connection to the X server and the wakeup event, 
+		so it uses no CPU while idle and can be woken up to stop without waiting for an X event.
+	*/
+	void _run_event_loop(std::stop_token const stop_token) {
+		auto const wake_on_stop = std::stop_callback{stop_token, [this] { _wake_event_loop(); }};
+
+		auto descriptors = std::array{
+			::pollfd{.fd = ConnectionNumber(_server.get()), .events = POLLIN},
+			::pollfd{.fd = _wakeup_event.get(), .events = POLLIN},
+		};
+		while (!stop_token.stop_requested()) {
+			// Xlib may already have read events from the connection into its queue, 
+			// and those would not wake up poll, so the queue is always drained first.
+			_has_unflushed_requests.store(false, std::memory_order::relaxed);
+			_handle_pending_events();
+			if (stop_token.stop_requested()) {
+				break;
+			}
+
+			// XPending does not flush when Xlib already has queued events, which round trips 
+			// made by other threads can leave behind, so the requests are always flushed here.
+			::XFlush(_server.get());
+			if (::XEventsQueued(_server.get(), QueuedAlready) > 0) {
+				continue;
+			}
+
+			if (::poll(descriptors.data(), descriptors.size(), -1) < 0 && errno != EINTR) {
+				break;
+			}
+			if (descriptors[1].revents & POLLIN) {
+				auto count = std::uint64_t{};
+				static_cast<void>(::read(_wakeup_event.get(), &count, sizeof(count)));
+			}
+		}
+	}
+	void _handle_pending_events() {
+		for (auto pending_count = ::XPending(_server.get()); pending_count > 0; 
+			pending_count = ::XEventsQueued(_server.get(), QueuedAfterReading)) 
+		{
+			while (pending_count-- > 0) {
+				auto event = ::XEvent{};
+				::XNextEvent(_server.get(), &event);
+
+				// A window of 0 filters the event for the window that it belongs to.
+				if (!::XFilterEvent(&event, ::Window{})) {
+					_dispatch_event(event);
+				}
+			}
+		}
+	}
+	void _dispatch_event(::XEvent const& event) {
+		auto lock = std::unique_lock{_windows_mutex};
+		auto const window = _windows.find(event.xany.window);
+		if (window == _windows.end()) {
+			return;
+		}
+		// The handler is copied, so that it stays valid if the window is removed by another handler.
+		auto const handler = window->second;
+		_dispatched_window = event.xany.window;
+		lock.unlock();
+
+		handler(event);
+
+		lock.lock();
+		_dispatched_window = ::Window{};
+		lock.unlock();
+		_dispatch_finished.notify_all();
+	}
+
+	DisplayHandle _server;
+	Atoms _atoms;
+	XFreeHandle<::XVisualInfo> _visual_info;
+	ColormapHandle _colormap;
+	InputMethodHandle _input_method;
+	Factor _dip_to_pixel_factor;
+
+	std::mutex _windows_mutex;
+	std::unordered_map<::Window, EventHandler> _windows;
+	// The window whose handler is being called by the event thread, which remove_window waits for.
+	::Window _dispatched_window{};
+	std::condition_variable _dispatch_finished;
+
+	utils::FileDescriptor _wakeup_event{::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)};
+	std::atomic<bool> _has_unflushed_requests{};
+
+	// Declared last so that the event loop is stopped before anything it uses is destroyed.
+	std::jthread _thread;
+};
+
 } // namespace utils::x11
 
 //------------------------------
 
 class WindowStyleManager {
 public:
+	[[nodiscard]]
+	Factor dip_to_pixel_factor() const noexcept {
+		return _dip_to_pixel_factor;
+	}
 	[[nodiscard]]
 	Pixels dip_to_pixels(Dip const dip) const noexcept {
 		return static_cast<Pixels>(dip * _dip_to_pixel_factor);
@@ -374,8 +1050,8 @@ public:
 		return (_parameters.style & WindowStyleFlags::Resizable) != WindowStyleFlags::None;
 	}
 
-	void initialize_styles(::Display* const server, ::Window const window) const noexcept {
-		utils::x11::set_window_title(server, window, _parameters.title);
+	void initialize_styles(::Display* const server, utils::x11::Atoms const& atoms, ::Window const window) const noexcept {
+		utils::x11::set_window_title(server, atoms, window, _parameters.title);
 
 		update_resizable(server, window);
 		update_min_max_sizes(server, window);
@@ -412,11 +1088,10 @@ public:
 		return _parameters;
 	}
 
-	WindowStyleManager(::Display* const server, WindowParameters&& parameters) :
-		_parameters{std::move(parameters)}
-	{
-		_dip_to_pixel_factor = utils::x11::calculate_dip_to_pixel_factor(server);
-	}
+	WindowStyleManager(Factor const dip_to_pixel_factor, WindowParameters&& parameters) :
+		_parameters{std::move(parameters)},
+		_dip_to_pixel_factor{dip_to_pixel_factor}
+	{}
 
 private:
 	WindowParameters _parameters;
@@ -431,61 +1106,88 @@ private:
 class Window::Implementation {
 public:
 	void title(std::string_view const title) noexcept {
-		utils::x11::set_window_title(_server.get(), _handle.get(), title);
+		utils::x11::set_window_title(_server(), _connection->atoms(), _handle.get(), title);
+		_connection->request_flush();
 	}
 	[[nodiscard]]
 	std::string title() const {
-		return utils::x11::get_window_title(_server.get(), _handle.get());
+		return _connection->round_trip([&](::Display* const server) {
+			return utils::x11::get_window_title(server, _handle.get());
+		});
 	}
 
 	void position(math::Point<Pixels> const position) noexcept {
-		::XMoveWindow(_server.get(), _handle.get(), position.x, position.y);
-		::XFlush(_server.get());
+		::XMoveWindow(_server(), _handle.get(), position.x, position.y);
+		_connection->request_flush();
 	}
 
 	void size(math::Size<Dip> const size) {
-		_size = size;
+		_state.update([&](WindowSnapshot& state) { state.size = size; });
 		auto const pixel_size = _style_manager.dip_to_pixels(size);//.to<math::Size<unsigned int>>();
-		::XResizeWindow(_server.get(), _handle.get(), pixel_size.x, pixel_size.y);
-		::XFlush(_server.get());
+		::XResizeWindow(_server(), _handle.get(), pixel_size.x, pixel_size.y);
+		_connection->request_flush();
 	}
 	[[nodiscard]]
 	math::Size<Dip> size() const noexcept {
-		return _size;
+		return _state.load().size;
 	}
 
 	[[nodiscard]]
 	bool is_open() const noexcept {
-		return _is_open;
+		return _state.load().is_open;
+	}
+
+	[[nodiscard]]
+	WindowSnapshot snapshot() const noexcept {
+		return _state.load();
+	}
+
+	void flush() noexcept {
+		_connection->flush();
 	}
 
 	[[nodiscard]]
 	::Window native_handle() const {
 		return _handle.get();
 	}
+	[[nodiscard]]
+	::Display* native_display() const noexcept {
+		return _server();
+	}
 
 	Implementation(WindowParameters&& parameters) :
-		_server{::XOpenDisplay(nullptr)},
-		_size{parameters.size},
-		_style_manager{_server.get(), std::move(parameters)}
+		_connection{utils::x11::DisplayConnection::shared()},
+		_state{WindowSnapshot{.size = parameters.size, .dip_to_pixel_factor = _connection->dip_to_pixel_factor()}},
+		_style_manager{_connection->dip_to_pixel_factor(), std::move(parameters)}
 	{
 		_create_window();
 
 		_open_keyboard_input();
 
 		_setup_events();
-
-		_thread = std::jthread{utils::bind(&Implementation::_run_event_loop_thread, this)};
 	}
+	~Implementation() {
+		// After this, the event thread no longer calls _handle_event, so the rest can be destroyed.
+		_connection->remove_window(_handle.get());
+
+		// Other windows may keep the connection open, so the requests that destroy 
+		// the window are flushed instead of waiting for other requests to be sent.
+		_input_context = XIC{};
+		_handle = utils::x11::WindowHandle{};
+		_connection->request_flush();
+	}
+
+	Implementation(Implementation const&) = delete;
+	Implementation& operator=(Implementation const&) = delete;
 
 private:
-	void _create_window() {
-		auto const visual_info = utils::x11::select_opengl_visual(_server.get());
+	[[nodiscard]]
+	::Display* _server() const noexcept {
+		return _connection->server();
+	}
 
-		_colormap = utils::x11::ColormapHandle{
-			_server.get(), 
-			::XCreateColormap(_server.get(), RootWindow(_server.get(), visual_info->screen), visual_info->visual, 0)
-		};
+	void _create_window() {
+		auto const& visual_info = _connection->visual_info();
 
 		auto const& parameters = _style_manager.parameters();
 
@@ -493,47 +1195,47 @@ private:
 			.event_mask = ExposureMask | 
 				EnterWindowMask | LeaveWindowMask |
 				StructureNotifyMask | 
+				FocusChangeMask |
 				PointerMotionMask |
 				ButtonPressMask | ButtonReleaseMask |
 				ButtonMotionMask |
 				KeyPressMask | KeyReleaseMask,
-			.colormap = _colormap.get(),
+			.colormap = _connection->colormap(),
 		};
 		_handle = utils::x11::WindowHandle{
-			_server.get(),
+			_server(),
 			::XCreateWindow(
-				_server.get(),
+				_server(),
 				parameters.parent 
 					? std::any_cast<::Window>(parameters.parent->native_handle()) 
-					: RootWindow(_server.get(), visual_info->screen),
+					: RootWindow(_server(), visual_info.screen),
 				0, 0, // Initial x and y are ignored by the window manager
-				static_cast<unsigned int>(_style_manager.dip_to_pixels(_size.x)),
-				static_cast<unsigned int>(_style_manager.dip_to_pixels(_size.y)),
+				static_cast<unsigned int>(_style_manager.dip_to_pixels(parameters.size.x)),
+				static_cast<unsigned int>(_style_manager.dip_to_pixels(parameters.size.y)),
 				0,
-				visual_info->depth,
+				visual_info.depth,
 				InputOutput,
-				visual_info->visual,
+				visual_info.visual,
 				CWEventMask | CWBorderPixel | CWColormap,
 				&window_attributes
 			)
 		};
+		_connection->add_window(_handle.get(), [this](::XEvent const& event) { _handle_event(event); });
 
-		_style_manager.initialize_styles(_server.get(), _handle.get());
+		_style_manager.initialize_styles(_server(), _connection->atoms(), _handle.get());
 		
 		// Show the window.
-		::XMapWindow(_server.get(), _handle.get());
+		::XMapWindow(_server(), _handle.get());
 
-		auto const screen_size = utils::x11::get_screen_size(_server.get());
+		auto const screen_size = utils::x11::get_screen_size(_server());
 		position({
 			static_cast<Pixels>(std::lerp(0.f, static_cast<float>(screen_size.x) - parameters.size.x, parameters.position_factor.x)),
 			static_cast<Pixels>(std::lerp(0.f, static_cast<float>(screen_size.y) - parameters.size.y, parameters.position_factor.y))
 		});
 	}
 	void _open_keyboard_input() {
-		_input_method = utils::x11::InputMethodHandle{::XOpenIM(_server.get(), nullptr, nullptr, nullptr)};
-
 		_input_context = utils::x11::InputContextHandle{::XCreateIC(
-			_input_method.get(),
+			_connection->input_method(),
 			XNInputStyle, XIMPreeditNothing | XIMStatusNothing, // Input style flags.
 			XNClientWindow, _handle.get(),
 			XNFocusWindow, _handle.get(),
@@ -542,31 +1244,16 @@ private:
 	}
 	void _setup_events() {
 		// We want the window manager to tell us when the window should be closed.
-		// WM_PROTOCOLS is the atom used to identify messages sent from the window manager in a ClientMessage.
-		_window_manager_client_message_type = ::XInternAtom(_server.get(), "WM_PROTOCOLS", true);
-		
-		// This is the atom sent as the data in a ClientMessage with type WM_PROTOCOLS, to indicate the close event.
-		_window_close_event = ::XInternAtom(_server.get(), "WM_DELETE_WINDOW", 0);
-		
+		// WM_PROTOCOLS is the atom used to identify messages sent from the window manager in a ClientMessage,
+		// and WM_DELETE_WINDOW is sent as the data in such a message to indicate the close event.
 		// Tell the window manager that we want it to send the event through WM_PROTOCOLS.
-		::XSetWMProtocols(_server.get(), _handle.get(), &_window_close_event, 1);
-
-		::XFlush(_server.get());
+		auto close_event = _connection->atoms().wm_delete_window;
+		::XSetWMProtocols(_server(), _handle.get(), &close_event, 1);
 	}
 
-	void _run_event_loop_thread() {
-		XInitThreads();
-
-		for (::XEvent event; _is_open;) {
-			::XNextEvent(_server.get(), &event);
-
-			if (XFilterEvent(&event, _handle.get())) {
-				continue;
-			}
-
-			_handle_event(event);
-		}
-	}
+	/*
+		Called on the event thread of the display connection.
+	*/
 	void _handle_event(::XEvent const& event) {
 		switch (event.type) {
 			case ConfigureNotify:
@@ -575,37 +1262,39 @@ private:
 			case ClientMessage:
 				_handle_client_message(event);
 				break;
+			case FocusIn:
+			case FocusOut:
+				_state.update([&](WindowSnapshot& state) { state.has_focus = event.type == FocusIn; });
+				break;
 		};
 	}
 	void _handle_client_message(::XEvent const& event) {
-		if (event.xclient.message_type == _window_manager_client_message_type) {
+		auto const& atoms = _connection->atoms();
+		if (event.xclient.message_type == atoms.wm_protocols) {
 			// Sent from the window manager when the user has tried to close the window,
 			// it is up to us to decide whether to actually close and exit the application.
-			if (static_cast<::Atom>(event.xclient.data.l[0]) == _window_close_event) {
-				_is_open = false;
+			if (static_cast<::Atom>(event.xclient.data.l[0]) == atoms.wm_delete_window) {
+				_state.update([](WindowSnapshot& state) { state.is_open = false; });
 			}
 		}
 	}
 	void _handle_configure_notify(::XEvent const& event) {
-		_size = _style_manager.pixels_to_dip(math::Size{event.xconfigure.width, event.xconfigure.height});
+		_state.update([&](WindowSnapshot& state) {
+			state.size = _style_manager.pixels_to_dip(math::Size{event.xconfigure.width, event.xconfigure.height});
+			state.position = math::Point{event.xconfigure.x, event.xconfigure.y};
+		});
 	}
 
-	bool _is_open{true};
-
-	utils::x11::DisplayHandle _server;
+	// Declared first so that the connection outlives the resources of the window.
+	std::shared_ptr<utils::x11::DisplayConnection> _connection;
 	utils::x11::WindowHandle _handle;
-	utils::x11::ColormapHandle _colormap;
 	
-	math::Size<Dip> _size;
+	// Written by the event thread and read from any thread.
+	utils::SeqLock<WindowSnapshot> _state;
 
 	WindowStyleManager _style_manager;
 
-	::Atom _window_manager_client_message_type;
-	::Atom _window_close_event;
-	utils::x11::InputMethodHandle _input_method;
 	utils::x11::InputContextHandle _input_context;
-
-	std::jthread _thread;
 };
 #endif
 
@@ -631,9 +1320,20 @@ bool Window::is_open() const {
 	return _implementation->is_open();
 }
 
+WindowSnapshot Window::snapshot() const {
+	return _implementation->snapshot();
+}
+
+void Window::flush() {
+	_implementation->flush();
+}
+
 std::any Window::native_handle() const {
 	return _implementation->native_handle();
 }
+std::any Window::native_display() const {
+	return _implementation->native_display();
+}
 
 Window::Window(WindowParameters&& parameters) :
 	_implementation{std::make_unique<Implementation>(std::move(parameters))}
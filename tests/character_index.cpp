@@ -0,0 +1,117 @@
+#include "testing_header.hpp"
+
+template<avo::unicode::IsCodePoint T>
+void check_index_against_free_functions(avo::unicode::CharacterIndex<T> const& index, std::basic_string<T> const& string) {
+	auto const view = std::basic_string_view<T>{string};
+
+	auto expected_character_indices = std::vector<std::size_t>{};
+	auto actual_character_indices = std::vector<std::size_t>{};
+	for (auto const i : avo::utils::indices(string)) {
+		expected_character_indices.push_back(avo::unicode::character_index(view, i));
+		actual_character_indices.push_back(index.character_index(i));
+	}
+	REQUIRE(actual_character_indices == expected_character_indices);
+
+	auto expected_code_point_indices = std::vector<std::size_t>{};
+	auto actual_code_point_indices = std::vector<std::size_t>{};
+	for (auto const i : avo::utils::Range{index.character_count()}) {
+		expected_code_point_indices.push_back(avo::unicode::code_point_index(view, i));
+		actual_code_point_indices.push_back(index.code_point_index(i));
+	}
+	REQUIRE(actual_code_point_indices == expected_code_point_indices);
+
+	REQUIRE(index.character_count() == static_cast<std::size_t>(std::ranges::count_if(view, [](T const c) {
+		return avo::unicode::is_first_code_point(c);
+	})));
+	REQUIRE(index.character_index(string.size()) == index.character_count());
+	REQUIRE(index.code_point_index(index.character_count()) == string.size());
+}
+
+template<avo::unicode::IsCodePoint T>
+void test_character_index_with_edits(std::basic_string_view<T> const pieces_string) {
+	// Each piece is a single character.
+	auto pieces = std::vector<std::basic_string<T>>{};
+	for (auto i = std::size_t{}; i < pieces_string.size();) {
+		auto const length = static_cast<std::size_t>(avo::unicode::code_point_count(pieces_string[i]));
+		pieces.emplace_back(pieces_string.substr(i, length));
+		i += length;
+	}
+
+	auto engine = std::mt19937{27182};
+	auto const random = [&](std::size_t const max) {
+		return std::uniform_int_distribution<std::size_t>{0, max}(engine);
+	};
+	auto const random_text = [&] {
+		auto result = std::basic_string<T>{};
+		for (auto const _ [[maybe_unused]] : avo::utils::Range{random(20)}) {
+			result += pieces[random(pieces.size() - 1)];
+		}
+		return result;
+	};
+
+	auto string = random_text();
+	auto index = avo::unicode::CharacterIndex<T>{string, 4};
+	check_index_against_free_functions(index, string);
+
+	for (auto const _ [[maybe_unused]] : avo::utils::Range{150}) {
+		auto const view = std::basic_string_view<T>{string};
+		auto const start = avo::unicode::code_point_index(view, random(index.character_count()));
+		
+		switch (random(2)) {
+			case 0: {
+				auto const inserted = random_text();
+				string.insert(start, inserted);
+				index.insert(string, start, inserted.size());
+				break;
+			}
+			case 1: {
+				auto const end = avo::unicode::code_point_index(view, index.character_index(start) + random(10));
+				string.erase(start, end - start);
+				index.erase(string, start, end - start);
+				break;
+			}
+			default: {
+				auto const end = avo::unicode::code_point_index(view, index.character_index(start) + random(10));
+				auto const inserted = random_text();
+				string.replace(start, end - start, inserted);
+				index.replace(string, start, end - start, inserted.size());
+			}
+		}
+		check_index_against_free_functions(index, string);
+	}
+}
+
+TEST_CASE("avo::unicode::CharacterIndex with UTF-8 edits") {
+	test_character_index_with_edits(std::string_view{"a🪢bå√c d"});
+}
+TEST_CASE("avo::unicode::CharacterIndex with UTF-16 edits") {
+	test_character_index_with_edits(std::u16string_view{u"a🪢bå√c d"});
+}
+
+TEST_CASE("avo::unicode::character_count on long strings") {
+	auto engine = std::mt19937{16180};
+	auto const random = [&](std::uint32_t const max) {
+		return std::uniform_int_distribution<std::uint32_t>{0, max}(engine);
+	};
+	
+	auto utf8_string = std::string{};
+	auto utf16_string = std::u16string{};
+	for (auto const length : {0, 1, 15, 16, 17, 4079, 4080, 4081, 10000, 300000}) {
+		utf8_string.clear();
+		utf16_string.clear();
+		for (auto const _ [[maybe_unused]] : avo::utils::Range{length}) {
+			utf8_string += static_cast<char>(random(255));
+			utf16_string += static_cast<char16_t>(random(1) ? random(0xffff) : 0xd800 + random(0x7ff));
+		}
+		
+		auto const expected_utf8_count = std::ranges::count_if(utf8_string, [](char const c) {
+			return avo::unicode::is_first_code_point(c);
+		});
+		CHECK(avo::unicode::character_count(std::string_view{utf8_string}) == static_cast<std::size_t>(expected_utf8_count));
+
+		auto const expected_utf16_count = std::ranges::count_if(utf16_string, [](char16_t const c) {
+			return avo::unicode::is_first_code_point(c);
+		});
+		CHECK(avo::unicode::character_count(std::u16string_view{utf16_string}) == static_cast<std::size_t>(expected_utf16_count));
+	}
+}
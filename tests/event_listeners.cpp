@@ -32,3 +32,177 @@ TEST_CASE("avo::EventListeners test") {
     listeners(5.f);
     REQUIRE(result == 15.f);
 }
+
+TEST_CASE("avo::EventListeners removal by handle") {
+    auto result = 0;
+    auto listeners = avo::EventListeners<void(int)>{};
+
+    auto const add_value = [&](int const value) { result += value; };
+    auto const first = listeners.add(add_value);
+    auto const second = listeners.add(add_value);
+    CHECK(first != second);
+    CHECK(listeners.size() == 2);
+
+    listeners(1);
+    REQUIRE(result == 2);
+
+    CHECK(listeners.remove(second));
+    CHECK_FALSE(listeners.remove(second));
+    listeners(1);
+    REQUIRE(result == 3);
+
+    listeners -= first;
+    CHECK(listeners.empty());
+    listeners(1);
+    REQUIRE(result == 3);
+}
+
+namespace {
+
+int function_result = 0;
+
+void add_one(int) {
+    ++function_result;
+}
+void add_two(int) {
+    function_result += 2;
+}
+
+} // namespace
+
+TEST_CASE("avo::EventListeners removal of function pointers compares them") {
+    auto listeners = avo::EventListeners<void(int)>{};
+    listeners += &add_one;
+    listeners += &add_two;
+
+    listeners -= &add_two;
+    function_result = 0;
+    listeners(0);
+    REQUIRE(function_result == 1);
+}
+
+TEST_CASE("avo::EventListeners changed by a listener during notification") {
+    auto listeners = avo::EventListeners<void()>{};
+    auto calls = 0;
+
+    auto handle = avo::EventListenerHandle{};
+    handle = listeners.add([&] {
+        ++calls;
+        listeners.remove(handle);
+        listeners += [&] { calls += 10; };
+    });
+
+    // The change is only visible in the next notification.
+    listeners();
+    REQUIRE(calls == 1);
+    listeners();
+    REQUIRE(calls == 11);
+}
+
+TEST_CASE("avo::EventListeners keeps listener state when other listeners change") {
+    auto listeners = avo::EventListeners<void(std::vector<int>&)>{};
+    listeners += [count = 0](std::vector<int>& counts) mutable {
+        counts.push_back(++count);
+    };
+
+    auto counts = std::vector<int>{};
+    listeners(counts);
+    listeners(counts);
+    listeners += [](std::vector<int>&) {};
+    listeners(counts);
+    REQUIRE(counts == std::vector{1, 2, 3});
+}
+
+TEST_CASE("avo::EventListeners iteration") {
+    auto listeners = avo::EventListeners<int(int)>{};
+    listeners += [](int const value) { return value; };
+    listeners += [](int const value) { return value*2; };
+
+    auto sum = 0;
+    for (auto const& listener : listeners) {
+        sum += listener(3);
+    }
+    REQUIRE(sum == 9);
+}
+
+TEST_CASE("avo::EventListeners notified while listeners are added and removed on other threads") {
+    auto listeners = avo::EventListeners<void(int&)>{};
+    listeners += [](int& count) { ++count; };
+
+    auto is_done = std::atomic<bool>{};
+    auto modifiers = std::vector<std::jthread>{};
+    for ([[maybe_unused]] auto const i : avo::utils::Range{3}) {
+        modifiers.emplace_back([&] {
+            while (!is_done) {
+                auto const handle = listeners.add([](int& count) { count += 1000; });
+                listeners.remove(handle);
+            }
+        });
+    }
+
+    for ([[maybe_unused]] auto const i : avo::utils::Range{20000}) {
+        auto count = 0;
+        listeners(count);
+        // The first listener is always called, the others some of the time.
+        REQUIRE(count % 1000 == 1);
+    }
+    is_done = true;
+}
+
+TEST_CASE("avo::EventListeners queued notifications") {
+    auto listeners = avo::EventListeners<void(std::string const&, int)>{};
+    auto received = std::vector<std::pair<std::string, int>>{};
+    listeners += [&](std::string const& name, int const value) {
+        received.emplace_back(name, value);
+    };
+
+    CHECK(listeners.notify_queued() == 0);
+
+    listeners.post("first", 1);
+    listeners.post("second", 2);
+    CHECK(received.empty());
+    REQUIRE(listeners.has_queued());
+
+    CHECK(listeners.notify_queued() == 2);
+    CHECK(received == std::vector<std::pair<std::string, int>>{{"first", 1}, {"second", 2}});
+    CHECK_FALSE(listeners.has_queued());
+
+    received.clear();
+    listeners.coalesce_queued(true);
+    listeners.post("first", 1);
+    listeners.post("second", 2);
+    listeners.post("third", 3);
+    CHECK(listeners.notify_queued() == 1);
+    CHECK(received == std::vector<std::pair<std::string, int>>{{"third", 3}});
+}
+
+TEST_CASE("avo::EventListeners notifications posted from multiple threads") {
+    constexpr auto thread_count = 4;
+    constexpr auto posts_per_thread = 20000;
+
+    auto listeners = avo::EventListeners<void(int, int)>{};
+    auto last_values = std::array<int, thread_count>{};
+    auto notification_count = 0;
+    listeners += [&](int const thread, int const value) {
+        // Notifications from one thread arrive in the order they were posted.
+        REQUIRE(value == last_values[static_cast<std::size_t>(thread)] + 1);
+        last_values[static_cast<std::size_t>(thread)] = value;
+        ++notification_count;
+    };
+
+    {
+        auto producers = std::vector<std::jthread>{};
+        for (auto const thread : avo::utils::Range{thread_count}) {
+            producers.emplace_back([&listeners, thread] {
+                for (auto const value : avo::utils::Range{1, posts_per_thread}) {
+                    listeners.post(thread, value);
+                }
+            });
+        }
+        while (notification_count < thread_count*posts_per_thread) {
+            listeners.notify_queued();
+        }
+    }
+    CHECK(listeners.notify_queued() == 0);
+    CHECK(notification_count == thread_count*posts_per_thread);
+}
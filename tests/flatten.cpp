@@ -143,3 +143,26 @@ TEST_CASE("avo::utils::flatten with nodes with stored parent") {
     auto [tree, expected_ids] = construct_test_with_parent_nodes();
     test_flatten_with_node_type(*tree, expected_ids);
 }
+
+TEST_CASE("avo::utils::flatten with a tree deeper than the inline parent stack") {
+    constexpr auto depth = 100;
+
+    // Every node has one leaf child and one child that continues the chain.
+    auto tree = TestNode{.id = 0};
+    auto* node = &tree;
+    auto expected_ids = std::vector{0};
+    for (auto const level : avo::utils::Range{1, depth}) {
+        node->children = std::vector{TestNode{.id = -level}, TestNode{.id = level}};
+        expected_ids.push_back(-level);
+        expected_ids.push_back(level);
+        node = &node->children.back();
+    }
+
+    CHECK(std::ranges::equal(tree | avo::utils::flatten, expected_ids, {}, &TestNode::id));
+
+    auto iterator = avo::utils::flatten(tree).begin();
+    std::ranges::advance(iterator, 150);
+    auto const copy = iterator++;
+    CHECK((*copy).id == expected_ids[150]);
+    CHECK((*iterator).id == expected_ids[151]);
+}
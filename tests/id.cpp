@@ -0,0 +1,37 @@
+#include "testing_header.hpp"
+
+TEST_CASE("avo::Id::next from multiple threads") {
+	constexpr auto number_of_threads = 8;
+	constexpr auto ids_per_thread = 5000;
+
+	auto ids = std::array<std::vector<avo::Id>, number_of_threads>{};
+	{
+		auto threads = std::vector<std::jthread>{};
+		for (auto& thread_ids : ids) {
+			threads.emplace_back([&thread_ids] {
+				for (auto const _ [[maybe_unused]] : avo::utils::Range{ids_per_thread}) {
+					thread_ids.push_back(avo::Id::next());
+				}
+			});
+		}
+	}
+
+	auto all_ids = std::vector<avo::Id::value_type>{};
+	for (auto const& thread_ids : ids) {
+		std::ranges::transform(thread_ids, std::back_inserter(all_ids), &avo::Id::value);
+	}
+	std::ranges::sort(all_ids);
+	
+	CHECK(all_ids.size() == number_of_threads*ids_per_thread);
+	CHECK(std::ranges::adjacent_find(all_ids) == all_ids.end());
+	CHECK(all_ids.front() != avo::Id::value_type{});
+}
+
+TEST_CASE("avo::Id named literals") {
+	using namespace avo::literals;
+
+	constexpr auto id = "some_id"_id;
+	CHECK(id == avo::Id::from_name("some_id"));
+	CHECK(id != avo::Id{});
+	CHECK(avo::theme_colors::primary != avo::theme_colors::secondary);
+}
@@ -0,0 +1,90 @@
+#include "testing_header.hpp"
+
+#include <unordered_map>
+
+TEST_CASE("avo::IdMap agrees with std::unordered_map") {
+	auto engine = std::mt19937{14142};
+	auto const random = [&](std::uint64_t const max) {
+		return std::uniform_int_distribution<std::uint64_t>{1, max}(engine);
+	};
+
+	auto map = avo::IdMap<int>{};
+	auto expected = std::unordered_map<avo::Id, int>{};
+
+	for (auto const i : avo::utils::Range{20000}) {
+		auto const id = avo::Id{random(2000)};
+		switch (random(4)) {
+			case 1:
+				map.insert_or_assign(id, i);
+				expected.insert_or_assign(id, i);
+				break;
+			case 2:
+				CHECK(map.erase(id) == expected.erase(id));
+				break;
+			case 3:
+				map[id] += i;
+				expected[id] += i;
+				break;
+			default:
+				CHECK(map.insert({id, i}).second == expected.insert({id, i}).second);
+		}
+	}
+	
+	REQUIRE(map.size() == expected.size());
+	for (auto const& [id, value] : map) {
+		REQUIRE(expected.contains(id));
+		REQUIRE(expected.at(id) == value);
+	}
+	for (auto const& [id, value] : expected) {
+		REQUIRE(map.at(id) == value);
+	}
+	CHECK_THROWS_AS(map.at(avo::Id{3000}), std::out_of_range);
+	CHECK(map.find(avo::Id{3000}) == map.end());
+	CHECK_FALSE(map.contains(avo::Id{}));
+}
+
+TEST_CASE("avo::IdMap keys can not be modified through iterators") {
+	using Map = avo::IdMap<int>;
+	static_assert(std::same_as<decltype((Map::Iterator{}->first)), avo::Id const&>);
+	static_assert(std::same_as<decltype((Map::Iterator{}->second)), int&>);
+
+	auto map = Map{{avo::Id{1}, 1}, {avo::Id{2}, 2}, {avo::Id{3}, 3}};
+	for (auto& [id, value] : map) {
+		value *= 10;
+	}
+	CHECK(map.erase(avo::Id{2}) == 1);
+	
+	auto copy = Map{};
+	copy = map;
+	CHECK(copy == Map{{avo::Id{1}, 10}, {avo::Id{3}, 30}});
+	copy.clear();
+	CHECK(copy.empty());
+	CHECK_FALSE(copy.contains(avo::Id{1}));
+}
+
+TEST_CASE("avo::Theme with avo::IdMap") {
+	auto theme = avo::Theme{};
+	CHECK(theme.colors.size() == 10);
+	CHECK(theme.colors.at(avo::theme_colors::primary) == avo::Color{0xff6200ea});
+	CHECK(theme.easings.at(avo::theme_easings::out) == avo::Easing{{0.1f, 0.9f}, {0.2f, 1.f}});
+	
+	theme.value(avo::theme_values::hover_animation_duration, 30.f);
+	CHECK(theme.values.at(avo::theme_values::hover_animation_duration) == 30.f);
+}
+
+namespace {
+
+struct ThrowingMove {
+	ThrowingMove() = default;
+	ThrowingMove(ThrowingMove&&) {}
+	ThrowingMove& operator=(ThrowingMove&&) { return *this; }
+};
+
+template<typename T>
+concept IsIdMapValue = requires { typename avo::IdMap<T>; };
+
+} // namespace
+
+// Entries are moved between slots in place, which would leave a destroyed slot behind if a move threw.
+static_assert(IsIdMapValue<int>);
+static_assert(!IsIdMapValue<ThrowingMove>);
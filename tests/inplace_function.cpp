@@ -0,0 +1,61 @@
+#include "testing_header.hpp"
+
+TEST_CASE("avo::utils::InplaceFunction stores small callables inline") {
+    auto value = 0;
+    auto const small = [&value](int const added) { return value += added; };
+    auto const large = [&value, padding = std::array<std::int64_t, 8>{}](int const added) { 
+        return value += added + static_cast<int>(padding[0]); 
+    };
+
+    using Function = avo::utils::InplaceFunction<int(int)>;
+    static_assert(Function::stores_inline<decltype(small)>());
+    static_assert(!Function::stores_inline<decltype(large)>());
+
+    auto small_function = Function{small};
+    auto large_function = Function{large};
+    CHECK(small_function(1) == 1);
+    CHECK(large_function(2) == 3);
+
+    CHECK(small_function.target_type() == avo::utils::type_tag<std::remove_const_t<decltype(small)>>);
+    CHECK(small_function.target<std::remove_const_t<decltype(large)>>() == nullptr);
+    CHECK(large_function.target<std::remove_const_t<decltype(large)>>() != nullptr);
+}
+
+TEST_CASE("avo::utils::InplaceFunction copy and move") {
+    auto const counter = std::make_shared<int>(0);
+
+    using Function = avo::utils::InplaceFunction<int()>;
+    auto function = Function{[counter] { return ++*counter; }};
+    CHECK(counter.use_count() == 2);
+
+    auto copy = function;
+    CHECK(counter.use_count() == 3);
+    CHECK(copy() == 1);
+    CHECK(function() == 2);
+
+    auto moved = std::move(function);
+    CHECK_FALSE(function);
+    CHECK(counter.use_count() == 3);
+    CHECK(moved() == 3);
+
+    moved = Function{};
+    copy = Function{};
+    CHECK(counter.use_count() == 1);
+}
+
+TEST_CASE("avo::utils::type_tag") {
+    CHECK(avo::utils::type_tag<int> == avo::utils::type_tag<int>);
+    CHECK(avo::utils::type_tag<int> != avo::utils::type_tag<float>);
+    CHECK(avo::utils::type_tag<int> != avo::utils::type_tag<int const>);
+}
+
+TEST_CASE("avo::utils::type_id") {
+    static_assert(avo::utils::type_id<int> == avo::utils::type_id<int>);
+    static_assert(avo::utils::type_id<int> != avo::utils::type_id<float>);
+    static_assert(avo::utils::type_id<int> != avo::utils::type_id<int const>);
+    static_assert(avo::utils::type_id<int> != avo::utils::TypeId{});
+
+    CHECK_NOTHROW(avo::utils::check_type_id<int>());
+    CHECK_NOTHROW(avo::utils::check_type_id<float>());
+    CHECK_NOTHROW(avo::utils::check_type_id<int>());
+}
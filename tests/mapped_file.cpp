@@ -0,0 +1,73 @@
+#include "testing_header.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+#ifdef __linux__
+/*
+	Returns the number of mappings of the file in this process.
+*/
+std::size_t count_mappings(std::string_view const path) {
+	auto maps = std::ifstream{"/proc/self/maps"};
+	auto count = std::size_t{};
+	for (auto line = std::string{}; std::getline(maps, line);) {
+		count += line.ends_with(path);
+	}
+	return count;
+}
+#endif
+
+} // namespace
+
+TEST_CASE("avo::utils::MappedFile has the same data as avo::utils::read_file") {
+	auto const path = (std::filesystem::temp_directory_path() / "avogui_mapped_file_test").string();
+
+	auto data = avo::utils::DataVector(100000);
+	auto engine = std::mt19937{};
+	std::ranges::generate(data, [&] { 
+		return static_cast<std::byte>(std::uniform_int_distribution<int>{0, 255}(engine)); 
+	});
+	avo::utils::write_to_file(data, path);
+
+	for (auto const access_pattern : {
+		avo::utils::FileAccessPattern::Normal, 
+		avo::utils::FileAccessPattern::Sequential, 
+		avo::utils::FileAccessPattern::Random
+	}) {
+		auto const file = avo::utils::MappedFile{path, access_pattern};
+		CHECK(std::ranges::equal(file.data(), data));
+		CHECK(std::ranges::equal(file.data(), avo::utils::read_file(path)));
+#ifdef __linux__
+		CHECK(file.is_memory_mapped());
+#endif
+	}
+
+	// The mapping is owned by the new object after a move.
+	auto file = avo::utils::MappedFile{path};
+	auto const moved_file = std::move(file);
+	CHECK(moved_file.size() == data.size());
+	CHECK(file.empty());
+
+	// Move assignment releases the mapping that was replaced.
+	{
+		auto assigned_file = avo::utils::MappedFile{path};
+		assigned_file = avo::utils::MappedFile{path};
+		CHECK(assigned_file.size() == data.size());
+#ifdef __linux__
+		CHECK(count_mappings(path) == 2);
+#endif
+	}
+#ifdef __linux__
+	CHECK(count_mappings(path) == 1);
+#endif
+
+	avo::utils::write_to_file(avo::utils::DataVector{}, path);
+	auto const empty_file = avo::utils::MappedFile{path};
+	CHECK(empty_file.empty());
+	CHECK_FALSE(empty_file.is_memory_mapped());
+
+	std::filesystem::remove(path);
+	CHECK(avo::utils::MappedFile{path}.empty());
+}
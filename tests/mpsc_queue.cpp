@@ -0,0 +1,39 @@
+#include "testing_header.hpp"
+
+TEST_CASE("avo::utils::MpscQueue consumes oldest first") {
+    auto queue = avo::utils::MpscQueue<std::unique_ptr<int>>{};
+    CHECK(queue.empty());
+    CHECK_FALSE(queue.consume_newest());
+
+    for (auto const i : avo::utils::Range{5}) {
+        queue.push(std::make_unique<int>(i));
+    }
+    CHECK_FALSE(queue.empty());
+
+    auto consumed = std::vector<int>{};
+    CHECK(queue.consume_all([&](std::unique_ptr<int>& value) { consumed.push_back(*value); }) == 5);
+    CHECK(consumed == std::vector{0, 1, 2, 3, 4});
+    CHECK(queue.empty());
+
+    for (auto const i : avo::utils::Range{5}) {
+        queue.push(std::make_unique<int>(i));
+    }
+    auto const newest = queue.consume_newest();
+    REQUIRE(newest);
+    CHECK(**newest == 4);
+    CHECK(queue.empty());
+
+    // Elements left in the queue are destroyed with it.
+    queue.push(std::make_unique<int>(5));
+}
+
+TEST_CASE("avo::utils::MpscQueue elements left after a throwing consumer are destroyed") {
+    auto const value = std::make_shared<int>();
+    auto queue = avo::utils::MpscQueue<std::shared_ptr<int>>{};
+    for ([[maybe_unused]] auto const i : avo::utils::Range{3}) {
+        queue.push(value);
+    }
+    CHECK_THROWS(queue.consume_all([](std::shared_ptr<int>&) { throw std::runtime_error{"consume"}; }));
+    CHECK(queue.empty());
+    CHECK(value.use_count() == 1);
+}
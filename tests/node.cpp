@@ -23,6 +23,8 @@ class App {
 public:
 	App() : _node{*this}
 	{
+		// Nodes point to their components, so the components must not be moved by reallocation.
+		_other_components.reserve(4);
 		_other_components.emplace_back(_component_0.get_node(), avo::Id{3}, 10);
 		_other_components.emplace_back(_component_0.get_node(), avo::Id{4}, 11);
 		_other_components.emplace_back(_component_1.get_node(), avo::Id{4}, 12);
@@ -85,3 +87,339 @@ TEST_CASE("Nodes with IDs") {
 	REQUIRE(app.get_node()[1].component<SomeComponent>()->value() == 8);
 }
 
+
+namespace {
+
+/*
+	Finds the nodes with an ID by traversing the tree, to compare with the results from an ID index.
+*/
+std::vector<avo::Node const*> traverse_for_id(avo::Node const& node, avo::Id const id) {
+	auto found_nodes = std::vector<avo::Node const*>{};
+	for (auto const& found : node | avo::utils::flatten) {
+		if (found.id() == id) {
+			found_nodes.push_back(&found);
+		}
+	}
+	std::ranges::sort(found_nodes);
+	return found_nodes;
+}
+
+void check_id_lookups(avo::Node const& node, avo::Id const id) {
+	auto found_nodes = std::vector<avo::Node const*>{};
+	for (auto const& found : avo::find_nodes_by_id(node, id)) {
+		found_nodes.push_back(&found);
+	}
+	std::ranges::sort(found_nodes);
+
+	auto const expected = traverse_for_id(node, id);
+	REQUIRE(found_nodes == expected);
+
+	auto const* const found = avo::find_node_by_id(node, id);
+	REQUIRE((found == nullptr) == expected.empty());
+	if (found) {
+		REQUIRE(std::ranges::binary_search(expected, found));
+	}
+}
+
+} // namespace
+
+TEST_CASE("Node ID index") {
+	auto root = avo::Node{};
+	root.enable_id_index();
+	REQUIRE(root.has_id_index());
+
+	auto a = avo::Node{root, avo::Id{1}, root};
+	auto b = avo::Node{root, avo::Id{2}, root};
+	auto c = avo::Node{a, avo::Id{2}, root};
+
+	CHECK(avo::find_node_by_id(root, avo::Id{1}) == &a);
+	CHECK(std::ranges::distance(avo::find_nodes_by_id(root, avo::Id{2})) == 2);
+	CHECK(avo::find_node_by_id(a, avo::Id{2}) == &c);
+	CHECK(avo::find_node_by_id(b, avo::Id{1}) == nullptr);
+
+	c.id(avo::Id{3});
+	CHECK(avo::find_node_by_id(root, avo::Id{2}) == &b);
+	CHECK(avo::find_node_by_id(root, avo::Id{3}) == &c);
+
+	auto other_root = avo::Node{};
+	other_root.enable_id_index();
+	a.parent(other_root);
+	CHECK(&c.root() == &other_root);
+	CHECK(avo::find_node_by_id(root, avo::Id{3}) == nullptr);
+	CHECK(avo::find_node_by_id(other_root, avo::Id{3}) == &c);
+
+	auto moved_a = std::move(a);
+	CHECK(avo::find_node_by_id(other_root, avo::Id{1}) == &moved_a);
+	CHECK(c.parent() == &moved_a);
+	
+	moved_a.detach();
+	CHECK_FALSE(moved_a.has_id_index());
+	CHECK(avo::find_node_by_id(other_root, avo::Id{1}) == nullptr);
+	CHECK(avo::find_node_by_id(moved_a, avo::Id{3}) == &c);
+}
+
+TEST_CASE("find_nodes_by_id is lazy") {
+	static_assert(std::ranges::forward_range<decltype(avo::find_nodes_by_id(std::declval<avo::Node&>(), avo::Id{}))>);
+	static_assert(std::ranges::view<decltype(avo::find_nodes_by_id(std::declval<avo::Node const&>(), avo::Id{}))>);
+
+	auto root = avo::Node{};
+	auto a = avo::Node{root, avo::Id{1}, root};
+	auto b = avo::Node{a, avo::Id{2}, root};
+	auto c = avo::Node{root, avo::Id{2}, root};
+
+	auto const found_nodes = avo::find_nodes_by_id(root, avo::Id{2});
+	CHECK(std::ranges::equal(found_nodes | std::views::transform([](auto& node) { return &node; }), std::array{&b, &c}));
+
+	// The nodes are found when the view is iterated, not when it is created.
+	c.id(avo::Id{3});
+	CHECK(std::ranges::distance(found_nodes) == 1);
+
+	root.enable_id_index();
+	CHECK(&*found_nodes.begin() == &b);
+	CHECK(std::ranges::distance(avo::find_nodes_by_id(a, avo::Id{3})) == 0);
+}
+
+TEST_CASE("Node ID index with random changes to the trees") {
+	auto engine = std::mt19937{31415};
+	auto const random = [&](std::size_t const max) {
+		return std::uniform_int_distribution<std::size_t>{0, max}(engine);
+	};
+	auto const random_id = [&] {
+		return avo::Id{random(20)};
+	};
+
+	constexpr auto root_count = std::size_t{3};
+	auto nodes = std::vector<std::unique_ptr<avo::Node>>{};
+	for ([[maybe_unused]] auto const i : avo::utils::Range{root_count}) {
+		nodes.push_back(std::make_unique<avo::Node>());
+		nodes.back()->enable_id_index();
+	}
+	for ([[maybe_unused]] auto const i : avo::utils::Range{300}) {
+		auto& parent = *nodes[random(nodes.size() - 1)];
+		nodes.push_back(std::make_unique<avo::Node>(parent, random_id(), parent));
+	}
+
+	for ([[maybe_unused]] auto const i : avo::utils::Range{3000}) {
+		auto const node_index = root_count + random(nodes.size() - root_count - 1);
+		auto& node = *nodes[node_index];
+		switch (random(5)) {
+			case 0: {
+				// Reparenting, possibly to another root.
+				auto& new_parent = *nodes[random(nodes.size() - 1)];
+				if (!new_parent.is_in_subtree_of(node)) {
+					node.parent(new_parent);
+				}
+				break;
+			}
+			case 1:
+				node.id(random_id());
+				break;
+			case 2:
+				nodes[node_index] = std::make_unique<avo::Node>(std::move(node));
+				break;
+			case 3: {
+				auto& other = *nodes[root_count + random(nodes.size() - root_count - 1)];
+				if (&other != &node && !node.is_in_subtree_of(other)) {
+					other = std::move(node);
+				}
+				break;
+			}
+			case 4:
+				// The children of a destroyed node become roots without an index.
+				nodes[node_index] = std::make_unique<avo::Node>(*nodes[random(root_count - 1)], random_id());
+				break;
+			default:
+				if (random(10) == 0) {
+					node.detach();
+				}
+		}
+
+		auto const& query_node = *nodes[random(nodes.size() - 1)];
+		check_id_lookups(query_node, random_id());
+	}
+
+	for (auto const& node : nodes) {
+		auto const* top = node.get();
+		while (top->parent()) {
+			top = top->parent();
+		}
+		REQUIRE(&node->root() == top);
+	}
+}
+
+TEST_CASE("Node components are only returned as their own type") {
+	auto value = 5;
+	auto const constant = 6.f;
+
+	auto root = avo::Node{value};
+	auto const child = avo::Node{root, constant};
+
+	CHECK(root.component<int>() == &value);
+	CHECK(root.component<float>() == nullptr);
+	CHECK(root.component<int const>() == nullptr);
+	
+	CHECK(child.component<float const>() == &constant);
+	CHECK(child.component<float>() == nullptr);
+
+	auto const moved = std::move(root);
+	CHECK(moved.component<int>() == &value);
+}
+
+TEST_CASE("Node child order and positions") {
+	auto root = avo::Node{};
+	auto children = std::vector<std::unique_ptr<avo::Node>>{};
+	for (auto const i : avo::utils::Range{1, 6}) {
+		children.push_back(std::make_unique<avo::Node>(root, avo::Id{static_cast<std::uint64_t>(i)}));
+	}
+
+	auto const child_ids = [&] {
+		auto ids = std::vector<std::uint64_t>{};
+		for (auto const& child : root) {
+			ids.push_back(static_cast<std::uint64_t>(child.id()));
+		}
+		return ids;
+	};
+	auto const check_positions = [&] {
+		for (auto const i : avo::utils::indices(root)) {
+			REQUIRE(root[i].index_in_parent() == i);
+		}
+	};
+
+	// The last child takes the place of the removed one.
+	children[1]->detach();
+	CHECK(child_ids() == std::vector<std::uint64_t>{1, 6, 3, 4, 5});
+	CHECK(children[1]->index_in_parent() == 0);
+	check_positions();
+
+	root.keep_child_order(true);
+	children[2]->detach();
+	CHECK(child_ids() == std::vector<std::uint64_t>{1, 6, 4, 5});
+	check_positions();
+
+	// A moved node takes the position of the node it was moved from.
+	auto moved = std::move(*children[3]);
+	CHECK(&root[2] == &moved);
+	check_positions();
+
+	children[1]->parent(root);
+	CHECK(child_ids() == std::vector<std::uint64_t>{1, 6, 4, 5, 2});
+	check_positions();
+
+	auto flattened_ids = std::vector<std::uint64_t>{};
+	auto grandchild = avo::Node{*children[0], avo::Id{7}};
+	for (auto const& node : root | avo::utils::flatten) {
+		flattened_ids.push_back(static_cast<std::uint64_t>(node.id()));
+	}
+	CHECK(flattened_ids == std::vector<std::uint64_t>{0, 1, 7, 6, 4, 5, 2});
+}
+
+TEST_CASE("Attaching and reparenting many nodes") {
+	auto root = avo::Node{};
+	root.enable_id_index();
+	auto children = std::vector<std::unique_ptr<avo::Node>>{};
+	for (auto const i : avo::utils::Range{1, 3}) {
+		children.push_back(std::make_unique<avo::Node>(avo::Id{static_cast<std::uint64_t>(i)}));
+	}
+	auto grandchild = avo::Node{*children[0], avo::Id{4}};
+
+	root.attach_children(children);
+	REQUIRE(root.size() == 3);
+	for (auto const i : avo::utils::indices(children)) {
+		CHECK(&root[i] == children[i].get());
+		CHECK(children[i]->index_in_parent() == i);
+	}
+	CHECK(avo::find_node_by_id(root, avo::Id{4}) == &grandchild);
+
+	auto other_root = avo::Node{};
+	auto existing_child = avo::Node{other_root, avo::Id{5}};
+	avo::reparent_all(root, other_root);
+	CHECK(root.size() == 0);
+	REQUIRE(other_root.size() == 4);
+	CHECK(&other_root[0] == &existing_child);
+	for (auto const i : avo::utils::indices(children)) {
+		CHECK(&other_root[i + 1] == children[i].get());
+		CHECK(children[i]->index_in_parent() == i + 1);
+	}
+	CHECK(&grandchild.root() == &other_root);
+	CHECK(avo::find_node_by_id(root, avo::Id{4}) == nullptr);
+	CHECK(avo::find_node_by_id(other_root, avo::Id{4}) == &grandchild);
+
+	CHECK_THROWS_AS(avo::reparent_all(other_root, *children[0]), std::invalid_argument);
+
+	// Moving into a node without children keeps the positions of the children.
+	avo::reparent_all(other_root, root);
+	CHECK(other_root.size() == 0);
+	CHECK(&root[3] == children[2].get());
+	CHECK(children[2]->index_in_parent() == 3);
+	CHECK(&grandchild.root() == &root);
+	CHECK(avo::find_node_by_id(root, avo::Id{4}) == &grandchild);
+}
+
+TEST_CASE("Iterating over dirty nodes") {
+	auto root = avo::Node{};
+	auto nodes = std::vector<std::unique_ptr<avo::Node>>{};
+	nodes.reserve(40);
+	// A tree with a branching factor of about 3.
+	for (auto const i : avo::utils::Range{40}) {
+		auto& parent = i < 3 ? root : *nodes[static_cast<std::size_t>(i/3 - 1)];
+		nodes.push_back(std::make_unique<avo::Node>(parent, avo::Id{static_cast<std::uint64_t>(i) + 1}));
+	}
+
+	auto const dirty_ids = [](avo::Node& subtree) {
+		auto ids = std::vector<avo::Id>{};
+		for (auto const& node : avo::dirty_nodes(subtree)) {
+			ids.push_back(node.id());
+		}
+		return ids;
+	};
+
+	CHECK(dirty_ids(root).empty());
+
+	nodes[30]->mark_dirty();
+	nodes[4]->mark_dirty();
+	nodes[1]->mark_dirty();
+	CHECK(root.has_dirty_descendant());
+	CHECK_FALSE(root.is_dirty());
+
+	// Pre-order, like flatten.
+	auto expected_ids = std::vector<avo::Id>{};
+	for (auto const& node : root | avo::utils::flatten) {
+		if (node.is_dirty()) {
+			expected_ids.push_back(node.id());
+		}
+	}
+	CHECK(expected_ids.size() == 3);
+	CHECK(dirty_ids(root) == expected_ids);
+
+	// All flags are cleared.
+	CHECK(dirty_ids(root).empty());
+	CHECK_FALSE(root.has_dirty_descendant());
+	for (auto const& node : root | avo::utils::flatten) {
+		CHECK_FALSE(node.is_dirty());
+		CHECK_FALSE(node.has_dirty_descendant());
+	}
+
+	// Stopping early keeps the rest of the flags.
+	nodes[5]->mark_dirty();
+	nodes[20]->mark_dirty();
+	root.mark_dirty();
+	{
+		auto dirty = avo::dirty_nodes(root);
+		auto iterator = dirty.begin();
+		CHECK(&*iterator == &root);
+		++iterator;
+		CHECK_FALSE(root.is_dirty());
+	}
+	CHECK(nodes[5]->is_dirty());
+	CHECK(dirty_ids(root).size() == 2);
+
+	// Attaching a dirty subtree marks its new ancestors.
+	auto detached = avo::Node{avo::Id{100}};
+	auto detached_child = avo::Node{detached, avo::Id{101}};
+	detached_child.mark_dirty();
+	detached.parent(*nodes[10]);
+	CHECK(nodes[2]->has_dirty_descendant());
+	CHECK(dirty_ids(*nodes[2]) == std::vector{avo::Id{101}});
+	CHECK(dirty_ids(root).empty());
+	CHECK_FALSE(root.has_dirty_descendant());
+}
@@ -0,0 +1,199 @@
+#include "testing_header.hpp"
+
+#include <map>
+
+TEST_CASE("avo::NodeArena structure") {
+	auto arena = avo::NodeArena<int>{};
+	auto const root = arena.create(0);
+	auto const a = arena.create(root, 1);
+	auto const b = arena.create(root, 2);
+	auto const a_child = arena.create(a, 3);
+	CHECK(arena.size() == 4);
+
+	auto const values = [&](auto const& handles) {
+		auto result = std::vector<int>{};
+		for (auto const handle : handles) {
+			result.push_back(arena[handle]);
+		}
+		return result;
+	};
+	CHECK(values(arena.pre_order(root)) == std::vector{0, 1, 3, 2});
+	CHECK(values(arena.children(root)) == std::vector{1, 2});
+	CHECK(arena.parent(a_child) == a);
+	CHECK(arena.next_sibling(a) == b);
+	CHECK(arena.previous_sibling(b) == a);
+	CHECK_FALSE(arena.parent(root));
+
+	arena.reparent(a, b);
+	CHECK(values(arena.pre_order(root)) == std::vector{0, 2, 1, 3});
+	CHECK_THROWS_AS(arena.reparent(b, a_child), std::invalid_argument);
+
+	arena.detach(b);
+	CHECK(values(arena.pre_order(root)) == std::vector{0});
+	CHECK(values(arena.pre_order(b)) == std::vector{2, 1, 3});
+
+	arena.destroy(b);
+	CHECK(arena.size() == 1);
+	CHECK_FALSE(arena.contains(a_child));
+	CHECK_THROWS_AS(arena.at(a), std::out_of_range);
+
+	// Slots are reused, but old handles stay invalid.
+	auto const reused = arena.create(root, 4);
+	CHECK(arena.contains(reused));
+	CHECK_FALSE(arena.contains(a));
+	CHECK(arena.at(reused) == 4);
+}
+
+namespace {
+
+struct ThrowingMove {
+	bool should_throw{};
+
+	ThrowingMove(bool const should_throw) :
+		should_throw{should_throw}
+	{}
+	ThrowingMove(ThrowingMove&& other) :
+		should_throw{other.should_throw}
+	{
+		if (should_throw) {
+			throw std::runtime_error{"Moved a ThrowingMove that should throw."};
+		}
+	}
+	ThrowingMove& operator=(ThrowingMove&&) = default;
+};
+
+} // namespace
+
+TEST_CASE("avo::NodeArena keeps the slot free when a value can not be constructed") {
+	auto arena = avo::NodeArena<ThrowingMove>{};
+	auto const root = arena.create(false);
+	arena.destroy(arena.create(root, false));
+
+	auto const reused = arena.create(root, false);
+	arena.destroy(reused);
+
+	CHECK_THROWS_AS(arena.create(root, true), std::runtime_error);
+	CHECK(arena.size() == 1);
+	// The slot that the failed node would have used is still the next one to be reused.
+	CHECK(arena.create(root, false).index == reused.index);
+}
+
+TEST_CASE("avo::NodeArena destroys deep and wide subtrees") {
+	auto arena = avo::NodeArena<int>{};
+	auto const root = arena.create(0);
+
+	auto const deep = arena.create(root, 1);
+	auto last = deep;
+	for (auto const i : avo::utils::Range{2, 2000}) {
+		last = arena.create(last, i);
+	}
+	auto const wide = arena.create(root, -1);
+	for (auto const i : avo::utils::Range{100}) {
+		arena.create(arena.create(wide, i), i);
+	}
+	CHECK(arena.size() == 1 + 2000 + 1 + 200);
+
+	arena.destroy(deep);
+	CHECK(arena.size() == 202);
+	CHECK_FALSE(arena.contains(last));
+	arena.destroy(wide);
+	CHECK(arena.size() == 1);
+	CHECK(std::ranges::distance(arena.pre_order(root)) == 1);
+
+	// Every freed slot can be used again.
+	for (auto const i : avo::utils::Range{2201}) {
+		arena.create(root, i);
+	}
+	CHECK(arena.size() == 2202);
+	CHECK(std::ranges::distance(arena.children(root)) == 2201);
+}
+
+TEST_CASE("avo::NodeArena with random changes") {
+	auto engine = std::mt19937{1618};
+	auto const random = [&](std::size_t const max) {
+		return std::uniform_int_distribution<std::size_t>{0, max}(engine);
+	};
+
+	auto arena = avo::NodeArena<std::size_t>{};
+	// The expected parent and children of every live node, by value.
+	auto expected_parents = std::map<std::size_t, std::optional<std::size_t>>{};
+	auto handles = std::map<std::size_t, avo::NodeHandle>{};
+	auto next_value = std::size_t{};
+
+	auto const random_node = [&] {
+		return std::next(handles.begin(), static_cast<std::ptrdiff_t>(random(handles.size() - 1)))->first;
+	};
+	auto const is_in_subtree_of = [&](std::size_t node, std::size_t const ancestor) {
+		for (;; node = *expected_parents.at(node)) {
+			if (node == ancestor) {
+				return true;
+			}
+			if (!expected_parents.at(node)) {
+				return false;
+			}
+		}
+	};
+
+	for ([[maybe_unused]] auto const i : avo::utils::Range{5000}) {
+		auto const operation = handles.empty() ? 0 : random(4);
+		if (operation <= 1) {
+			auto const value = next_value++;
+			if (handles.empty() || (operation == 0 && random(10) == 0)) {
+				handles[value] = arena.create(value);
+				expected_parents[value] = std::nullopt;
+			}
+			else {
+				auto const parent = random_node();
+				handles[value] = arena.create(handles.at(parent), value);
+				expected_parents[value] = parent;
+			}
+		}
+		else if (operation == 2) {
+			auto const node = random_node();
+			auto const new_parent = random_node();
+			if (is_in_subtree_of(new_parent, node)) {
+				CHECK_THROWS_AS(arena.reparent(handles.at(node), handles.at(new_parent)), std::invalid_argument);
+			}
+			else {
+				arena.reparent(handles.at(node), handles.at(new_parent));
+				expected_parents[node] = new_parent;
+			}
+		}
+		else if (operation == 3 && random(3) == 0) {
+			auto const node = random_node();
+			auto const handle = handles.at(node);
+			arena.destroy(handle);
+			CHECK_FALSE(arena.contains(handle));
+			std::erase_if(handles, [&](auto const& entry) { return is_in_subtree_of(entry.first, node); });
+			std::erase_if(expected_parents, [&](auto const& entry) { return !handles.contains(entry.first); });
+		}
+		else {
+			auto const node = random_node();
+			arena.detach(handles.at(node));
+			expected_parents[node] = std::nullopt;
+		}
+
+		REQUIRE(arena.size() == handles.size());
+	}
+
+	for (auto const& [value, handle] : handles) {
+		REQUIRE(arena.contains(handle));
+		REQUIRE(arena[handle] == value);
+		auto const parent = arena.parent(handle);
+		REQUIRE(static_cast<bool>(parent) == expected_parents.at(value).has_value());
+		if (parent) {
+			REQUIRE(arena[parent] == *expected_parents.at(value));
+		}
+		for (auto const child : arena.children(handle)) {
+			REQUIRE(expected_parents.at(arena[child]) == value);
+		}
+		auto subtree_size = std::size_t{};
+		for (auto const descendant : arena.pre_order(handle)) {
+			REQUIRE(is_in_subtree_of(arena[descendant], value));
+			++subtree_size;
+		}
+		REQUIRE(subtree_size == static_cast<std::size_t>(std::ranges::count_if(handles, [&](auto const& entry) {
+			return is_in_subtree_of(entry.first, value);
+		})));
+	}
+}
@@ -0,0 +1,97 @@
+#include "testing_header.hpp"
+
+TEST_CASE("avo::utils::ThreadPool runs every task once") {
+	auto pool = avo::utils::ThreadPool{4};
+	REQUIRE(pool.thread_count() == 4);
+
+	for (auto const count : {std::size_t{0}, std::size_t{1}, std::size_t{3}, std::size_t{10000}}) {
+		auto runs = std::vector<std::atomic<int>>(count);
+		pool.for_each_index(count, [&](std::size_t const index) {
+			++runs[index];
+		});
+		REQUIRE(std::ranges::all_of(runs, [](auto const& run_count) { return run_count == 1; }));
+	}
+}
+
+TEST_CASE("avo::utils::ThreadPool with nested jobs and exceptions") {
+	auto pool = avo::utils::ThreadPool{3};
+
+	auto sum = std::atomic<std::size_t>{};
+	pool.for_each_index(10, [&](std::size_t const outer) {
+		pool.for_each_index(10, [&](std::size_t const inner) {
+			sum += outer*10 + inner;
+		});
+	});
+	CHECK(sum == 99*100/2);
+
+	auto run_count = std::atomic<int>{};
+	CHECK_THROWS_AS(pool.for_each_index(100, [&](std::size_t const index) {
+		++run_count;
+		if (index == 50) {
+			throw std::runtime_error{"task"};
+		}
+	}), std::runtime_error);
+	CHECK(run_count == 100);
+
+	// The pool is still usable.
+	run_count = 0;
+	pool.for_each_index(100, [&](std::size_t) { ++run_count; });
+	CHECK(run_count == 100);
+}
+
+namespace {
+
+struct Tree {
+	avo::Node root;
+	std::vector<std::unique_ptr<avo::Node>> nodes;
+};
+
+std::unique_ptr<Tree> make_random_tree(std::size_t const node_count) {
+	auto tree = std::make_unique<Tree>();
+	auto engine = std::mt19937{2718};
+	for (auto const i : avo::utils::Range{node_count}) {
+		// Mostly attached to recent nodes, which gives both deep and wide parts.
+		auto const parent_index = std::uniform_int_distribution<std::size_t>{i > 50 ? i - 50 : 0, i}(engine);
+		auto& parent = parent_index == 0 ? tree->root : *tree->nodes[parent_index - 1];
+		tree->nodes.push_back(std::make_unique<avo::Node>(parent, avo::Id{i % 97}));
+	}
+	return tree;
+}
+
+} // namespace
+
+TEST_CASE("Parallel traversal of a Node tree") {
+	auto const tree = make_random_tree(20000);
+	auto const& root = tree->root;
+
+	for (auto const thread_count : {1, 2, 5}) {
+		auto pool = avo::utils::ThreadPool{static_cast<std::size_t>(thread_count)};
+
+		auto visit_count = std::atomic<int>{};
+		avo::utils::for_each_parallel(root, [&](avo::Node const&) { ++visit_count; }, pool);
+		CHECK(visit_count == 20001);
+
+		auto const has_id = [](avo::Node const& node) { return node.id() == avo::Id{13}; };
+		auto expected = std::vector<avo::Node const*>{};
+		for (auto const& node : root | avo::utils::flatten) {
+			if (has_id(node)) {
+				expected.push_back(&node);
+			}
+		}
+		CHECK(avo::utils::find_all_parallel(root, has_id, pool) == expected);
+
+		auto const sum = avo::utils::transform_reduce_parallel(root, std::uint64_t{}, std::plus{}, 
+			[](avo::Node const& node) { return static_cast<std::uint64_t>(node.id()); }, pool);
+		CHECK(sum == std::transform_reduce(tree->nodes.begin(), tree->nodes.end(), std::uint64_t{}, std::plus{}, 
+			[](auto const& node) { return static_cast<std::uint64_t>(node->id()); }));
+
+		// Concatenation is not commutative, so this checks that the results are reduced in order.
+		auto const concatenate = [](std::vector<avo::Id> first, std::vector<avo::Id> const& second) {
+			first.insert(first.end(), second.begin(), second.end());
+			return first;
+		};
+		auto const ids = avo::utils::transform_reduce_parallel(root, std::vector<avo::Id>{}, concatenate, 
+			[](avo::Node const& node) { return std::vector{node.id()}; }, pool);
+		CHECK(std::ranges::equal(ids, root | avo::utils::flatten, {}, {}, [](avo::Node const& node) { return node.id(); }));
+	}
+}
@@ -0,0 +1,82 @@
+#include "testing_header.hpp"
+
+namespace {
+
+struct Consistent {
+	std::uint64_t a;
+	std::uint64_t doubled;
+	std::uint32_t incremented;
+	bool is_even;
+
+	[[nodiscard]]
+	bool is_consistent() const noexcept {
+		return doubled == a*2 && incremented == static_cast<std::uint32_t>(a + 1) && is_even == (a % 2 == 0);
+	}
+};
+
+[[nodiscard]]
+Consistent make_consistent(std::uint64_t const a) noexcept {
+	return {a, a*2, static_cast<std::uint32_t>(a + 1), a % 2 == 0};
+}
+
+} // namespace
+
+TEST_CASE("avo::utils::SeqLock stores and updates") {
+	auto lock = avo::utils::SeqLock<Consistent>{make_consistent(5)};
+	CHECK(lock.load().a == 5);
+	CHECK(lock.load().is_consistent());
+
+	lock.update([](Consistent& value) { value = make_consistent(value.a + 1); });
+	CHECK(lock.load().a == 6);
+	CHECK(lock.load().is_consistent());
+
+	// A throwing update leaves the value as it was and unlocks.
+	CHECK_THROWS(lock.update([](Consistent& value) {
+		value.a = 100;
+		throw std::runtime_error{"update"};
+	}));
+	CHECK(lock.load().a == 6);
+	lock.store(make_consistent(7));
+	CHECK(lock.load().a == 7);
+}
+
+TEST_CASE("avo::utils::SeqLock readers always see consistent values") {
+	constexpr auto number_of_readers = 3;
+	constexpr auto number_of_writers = 2;
+	constexpr auto writes_per_writer = 20000;
+
+	auto lock = avo::utils::SeqLock<Consistent>{make_consistent(0)};
+	auto is_done = std::atomic<bool>{};
+	auto inconsistent_count = std::atomic<int>{};
+	auto decreasing_count = std::atomic<int>{};
+
+	{
+		auto readers = std::vector<std::jthread>{};
+		for ([[maybe_unused]] auto const i : avo::utils::Range{number_of_readers}) {
+			readers.emplace_back([&] {
+				auto previous = std::uint64_t{};
+				while (!is_done.load(std::memory_order::relaxed)) {
+					auto const value = lock.load();
+					inconsistent_count += !value.is_consistent();
+					decreasing_count += value.a < previous;
+					previous = value.a;
+				}
+			});
+		}
+
+		auto writers = std::vector<std::jthread>{};
+		for ([[maybe_unused]] auto const i : avo::utils::Range{number_of_writers}) {
+			writers.emplace_back([&] {
+				for ([[maybe_unused]] auto const j : avo::utils::Range{writes_per_writer}) {
+					lock.update([](Consistent& value) { value = make_consistent(value.a + 1); });
+				}
+			});
+		}
+		writers.clear();
+		is_done = true;
+	}
+
+	CHECK(inconsistent_count == 0);
+	CHECK(decreasing_count == 0);
+	CHECK(lock.load().a == number_of_writers*writes_per_writer);
+}
@@ -0,0 +1,166 @@
+#include "testing_header.hpp"
+
+TEST_CASE("avo::Theme versions changed entries") {
+	auto theme = avo::Theme{};
+	auto const initial_version = theme.version();
+	CHECK(theme.version(avo::ThemeEntryKind::Color, avo::theme_colors::primary) == initial_version);
+	CHECK_FALSE(theme.has_changes());
+
+	theme.color(avo::theme_colors::primary, avo::Color{0xff00ff00});
+	CHECK(theme.color(avo::theme_colors::primary) == avo::Color{0xff00ff00});
+	auto const color_version = theme.version();
+	CHECK(color_version > initial_version);
+	CHECK(theme.version(avo::ThemeEntryKind::Color, avo::theme_colors::primary) == color_version);
+	// Entries of different kinds are versioned separately.
+	CHECK(theme.version(avo::ThemeEntryKind::Value, avo::theme_colors::primary) == initial_version);
+
+	theme.value(avo::theme_values::hover_animation_duration, 30.f);
+	CHECK(theme.value(avo::theme_values::hover_animation_duration) == 30.f);
+	CHECK(theme.version() > color_version);
+	CHECK(theme.version(avo::ThemeEntryKind::Color, avo::theme_colors::primary) == color_version);
+	CHECK(theme.version(avo::ThemeEntryKind::Value, avo::theme_values::hover_animation_duration) == theme.version());
+
+	auto const easing = avo::Easing{{0.2f, 0.f}, {0.8f, 1.f}};
+	theme.easing(avo::theme_easings::in, easing);
+	CHECK(theme.easing(avo::theme_easings::in) == easing);
+	CHECK(theme.version(avo::ThemeEntryKind::Easing, avo::theme_easings::in) == theme.version());
+}
+
+TEST_CASE("avo::Theme versions are unique across themes") {
+	auto const first = avo::Theme{};
+	auto const second = avo::Theme{};
+	CHECK(first.version() != second.version());
+
+	auto copy = first;
+	CHECK(copy.version() == first.version());
+	copy.color(avo::theme_colors::primary, avo::Color{0xff00ff00});
+	CHECK(copy.version() > second.version());
+}
+
+TEST_CASE("avo::Theme batches changes") {
+	auto theme = avo::Theme{};
+
+	theme.color(avo::theme_colors::primary, avo::Color{0xff00ff00});
+	theme.color(avo::theme_colors::secondary, avo::Color{0xff0000ff});
+	theme.color(avo::theme_colors::primary, avo::Color{0xffff0000});
+	theme.value(avo::theme_values::hover_animation_speed, 0.5f);
+	REQUIRE(theme.has_changes());
+
+	CHECK(theme.take_changes() == std::vector<avo::ThemeChange>{
+		{avo::ThemeEntryKind::Color, avo::theme_colors::primary},
+		{avo::ThemeEntryKind::Color, avo::theme_colors::secondary},
+		{avo::ThemeEntryKind::Value, avo::theme_values::hover_animation_speed},
+	});
+	CHECK_FALSE(theme.has_changes());
+	CHECK(theme.take_changes().empty());
+
+	theme.color(avo::theme_colors::primary, avo::Color{0xff00ff00});
+	theme.color(avo::theme_colors::primary, avo::Color{0xffff0000});
+	CHECK(theme.take_changes() == std::vector<avo::ThemeChange>{
+		{avo::ThemeEntryKind::Color, avo::theme_colors::primary},
+	});
+}
+
+TEST_CASE("avo::Theme notifies change listeners once per batch") {
+	auto theme = avo::Theme{};
+
+	auto notifications = std::vector<std::vector<avo::ThemeChange>>{};
+	theme.change_listeners() += [&](std::span<avo::ThemeChange const> const changes) {
+		notifications.emplace_back(changes.begin(), changes.end());
+	};
+
+	CHECK_FALSE(theme.notify_changes());
+	CHECK(notifications.empty());
+
+	theme.color(avo::theme_colors::primary, avo::Color{0xff00ff00});
+	theme.value(avo::theme_values::hover_animation_speed, 0.5f);
+	theme.color(avo::theme_colors::primary, avo::Color{0xffff0000});
+	CHECK(theme.notify_changes());
+	REQUIRE(notifications.size() == 1);
+	CHECK(notifications[0] == std::vector<avo::ThemeChange>{
+		{avo::ThemeEntryKind::Color, avo::theme_colors::primary},
+		{avo::ThemeEntryKind::Value, avo::theme_values::hover_animation_speed},
+	});
+	CHECK_FALSE(theme.has_changes());
+	CHECK_FALSE(theme.notify_changes());
+	CHECK(notifications.size() == 1);
+
+	// The listeners stay with the theme when it is replaced, and are not copied.
+	theme = avo::Theme{};
+	auto copy = theme;
+	copy.color(avo::theme_colors::primary, avo::Color{0xff00ff00});
+	CHECK(copy.notify_changes());
+	theme.color(avo::theme_colors::secondary, avo::Color{0xff0000ff});
+	CHECK(theme.notify_changes());
+	REQUIRE(notifications.size() == 2);
+	CHECK(notifications[1] == std::vector<avo::ThemeChange>{
+		{avo::ThemeEntryKind::Color, avo::theme_colors::secondary},
+	});
+}
+
+TEST_CASE("avo::ThemeEntryCache revalidates when the entry changes") {
+	auto theme = avo::Theme{};
+	auto cache = avo::ThemeEntryCache<avo::Color>{avo::theme_colors::primary};
+
+	CHECK(cache.get(theme) == theme.colors.at(avo::theme_colors::primary));
+
+	theme.color(avo::theme_colors::secondary, avo::Color{0xff0000ff});
+	CHECK(cache.get(theme) == theme.colors.at(avo::theme_colors::primary));
+
+	theme.color(avo::theme_colors::primary, avo::Color{0xff00ff00});
+	CHECK(cache.get(theme) == avo::Color{0xff00ff00});
+
+	theme.color(avo::theme_colors::primary, avo::Color{0xffff0000});
+	CHECK(cache.get(theme) == avo::Color{0xffff0000});
+
+	auto value_cache = avo::ThemeEntryCache<float>{avo::theme_values::hover_animation_duration};
+	CHECK(value_cache.get(theme) == 60.f);
+	theme.value(avo::theme_values::hover_animation_duration, 10.f);
+	CHECK(value_cache.get(theme) == 10.f);
+}
+
+TEST_CASE("avo::ThemeEntryCache revalidates when the theme is replaced") {
+	auto theme = avo::Theme{};
+	auto cache = avo::ThemeEntryCache<avo::Color>{avo::theme_colors::background};
+	CHECK(cache.get(theme) == theme.colors.at(avo::theme_colors::background));
+
+	// Neither theme has changed its background, so only the versions of the themes tell them apart.
+	theme = avo::Theme{
+		.colors = {
+			{avo::theme_colors::background, avo::Color{0xff00ff00}},
+		},
+	};
+	CHECK(cache.get(theme) == avo::Color{0xff00ff00});
+
+	auto other_theme = avo::Theme{};
+	CHECK(cache.get(other_theme) == other_theme.colors.at(avo::theme_colors::background));
+	CHECK(cache.get(theme) == avo::Color{0xff00ff00});
+}
+
+namespace {
+
+template<typename _Entries>
+concept AssignableByIndex = requires(_Entries entries) { entries[avo::Id{}] = {}; };
+
+} // namespace
+
+// The entries can only be changed through the versioned setters.
+static_assert(!AssignableByIndex<avo::ThemeEntries<avo::Color>>);
+
+TEST_CASE("avo::Theme is an aggregate") {
+	static_assert(std::is_aggregate_v<avo::Theme>);
+
+	auto theme = avo::Theme{
+		.colors = {
+			{avo::theme_colors::primary, avo::Color{0xff00ff00}},
+		},
+	};
+	CHECK(theme.colors.size() == 1);
+	CHECK(theme.color(avo::theme_colors::primary) == avo::Color{0xff00ff00});
+	CHECK(theme.easings.size() == 4);
+	CHECK_FALSE(theme.has_changes());
+
+	theme.color(avo::theme_colors::secondary, avo::Color{0xff0000ff});
+	CHECK(theme.colors.size() == 2);
+	CHECK(theme.version(avo::ThemeEntryKind::Color, avo::theme_colors::secondary) == theme.version());
+}
@@ -23,3 +23,148 @@ TEST_CASE("UTF-8 to UTF-16 with out parameter") {
 	CHECK(output_string_utf16 == utf16_string);
 	CHECK(*utf16_length == utf16_string.size());
 }
+TEST_CASE("Converted unicode string lengths") {
+	CHECK(avo::unicode::utf16_length_of(utf8_string) == utf16_string.size());
+	CHECK(avo::unicode::utf8_length_of(utf16_string) == utf8_string.size());
+
+	constexpr auto long_utf8_string = "🪢 här √ är knut, a knot is here. 🪢 här √ är knut, a knot is here."sv;
+	constexpr auto long_utf16_string = u"🪢 här √ är knut, a knot is here. 🪢 här √ är knut, a knot is here."sv;
+	CHECK(avo::unicode::utf16_length_of(long_utf8_string) == long_utf16_string.size());
+	CHECK(avo::unicode::utf8_length_of(long_utf16_string) == long_utf8_string.size());
+
+	CHECK(avo::unicode::utf16_length_of(""sv) == 0);
+	CHECK(avo::unicode::utf8_length_of(u""sv) == 0);
+}
+TEST_CASE("Unicode conversion with too small output") {
+	auto output_string_utf16 = std::u16string(utf16_string.size() - 1, '\0');
+	CHECK_FALSE(avo::unicode::utf8_to_utf16(utf8_string, output_string_utf16));
+
+	auto output_string_utf8 = std::string(utf8_string.size() - 1, '\0');
+	CHECK_FALSE(avo::unicode::utf16_to_utf8(utf16_string, output_string_utf8));
+}
+TEST_CASE("Unicode conversion of malformed input") {
+	auto output_string_utf16 = std::u16string(16, '\0');
+	CHECK_FALSE(avo::unicode::utf8_to_utf16("ab\xc0\x80", output_string_utf16)); // Overlong
+	CHECK_FALSE(avo::unicode::utf8_to_utf16("ab\xed\xa0\x80", output_string_utf16)); // Surrogate
+	CHECK_FALSE(avo::unicode::utf8_to_utf16("ab\xf4\x90\x80\x80", output_string_utf16)); // Above U+10FFFF
+	CHECK_FALSE(avo::unicode::utf8_to_utf16("ab\xe2\x88", output_string_utf16)); // Truncated
+	CHECK_FALSE(avo::unicode::utf8_to_utf16("ab\x80", output_string_utf16)); // Lone continuation byte
+
+	auto output_string_utf8 = std::string(16, '\0');
+	CHECK_FALSE(avo::unicode::utf16_to_utf8(u"ab\xd83e", output_string_utf8)); // Unpaired high surrogate
+	CHECK_FALSE(avo::unicode::utf16_to_utf8(u"ab\xdeac", output_string_utf8)); // Unpaired low surrogate
+}
+
+#ifndef _WIN32
+#include <iconv.h>
+
+template<typename _To, typename _From>
+std::optional<std::basic_string<_To>> convert_with_iconv(
+	char const* const to_code, char const* const from_code, 
+	std::basic_string_view<_From> const input) 
+{
+	auto const converter = iconv_open(to_code, from_code);
+	auto const cleanup = avo::utils::Cleanup{[&]{ iconv_close(converter); }};
+
+	auto output = std::basic_string<_To>(input.size()*4, _To{});
+
+	auto in_pointer = const_cast<char*>(reinterpret_cast<char const*>(input.data()));
+	auto in_bytes_left = input.size()*sizeof(_From);
+	auto out_pointer = reinterpret_cast<char*>(output.data());
+	auto out_bytes_left = output.size()*sizeof(_To);
+
+	if (iconv(converter, &in_pointer, &in_bytes_left, &out_pointer, &out_bytes_left) == static_cast<std::size_t>(-1)) {
+		return {};
+	}
+	output.resize(output.size() - out_bytes_left/sizeof(_To));
+	return output;
+}
+
+void append_utf8(std::string& string, char32_t const code_point) {
+	if (code_point < 0x80) {
+		string += static_cast<char>(code_point);
+	}
+	else if (code_point < 0x800) {
+		string += static_cast<char>(0xc0 | code_point >> 6);
+		string += static_cast<char>(0x80 | (code_point & 0x3f));
+	}
+	else if (code_point < 0x10000) {
+		string += static_cast<char>(0xe0 | code_point >> 12);
+		string += static_cast<char>(0x80 | (code_point >> 6 & 0x3f));
+		string += static_cast<char>(0x80 | (code_point & 0x3f));
+	}
+	else {
+		string += static_cast<char>(0xf0 | code_point >> 18);
+		string += static_cast<char>(0x80 | (code_point >> 12 & 0x3f));
+		string += static_cast<char>(0x80 | (code_point >> 6 & 0x3f));
+		string += static_cast<char>(0x80 | (code_point & 0x3f));
+	}
+}
+
+TEST_CASE("Unicode conversion agrees with iconv on random input") {
+	auto engine = std::mt19937{31415};
+	auto const random = [&](std::uint32_t const min, std::uint32_t const max) {
+		return std::uniform_int_distribution<std::uint32_t>{min, max}(engine);
+	};
+	// Mostly valid characters with ASCII runs long enough for the SIMD kernels, 
+	// and sometimes a single random code unit that is likely to be malformed.
+	auto const random_code_point = [&]() -> char32_t {
+		switch (random(0, 9)) {
+			case 0: return random(0x80, 0x7ff);
+			case 1: return random(0x800, 0xffff);
+			case 2: return random(0x10000, 0x10ffff);
+			default: return random(0, 0x7f);
+		}
+	};
+
+	for (auto test_number = 0; test_number < 20000; ++test_number) {
+		auto const length = random(0, 80);
+		
+		auto utf8_input = std::string{};
+		auto utf16_input = std::u16string{};
+		for (auto const i : avo::utils::Range{length}) {
+			if (random(0, 200) == 0) {
+				utf8_input += static_cast<char>(random(0, 255));
+				utf16_input += static_cast<char16_t>(random(0xd800, 0xdfff));
+			}
+			else {
+				auto const code_point = random_code_point();
+				if (code_point < 0xd800 || code_point > 0xdfff) {
+					append_utf8(utf8_input, code_point);
+				}
+				// Every other code point is written as UTF-16 directly, without going through UTF-8.
+				if (i % 2) {
+					utf16_input += static_cast<char16_t>(random(0, 0xffff));
+				}
+				else if (code_point < 0x10000) {
+					utf16_input += static_cast<char16_t>(code_point);
+				}
+				else {
+					utf16_input += static_cast<char16_t>(0xd800 + ((code_point - 0x10000) >> 10));
+					utf16_input += static_cast<char16_t>(0xdc00 + ((code_point - 0x10000) & 0x3ff));
+				}
+			}
+		}
+
+		auto utf16_output = std::u16string(utf8_input.size(), u'\0');
+		auto const utf16_length = avo::unicode::utf8_to_utf16(utf8_input, utf16_output);
+		auto const utf16_expected = convert_with_iconv<char16_t>("UTF-16LE", "UTF-8", std::string_view{utf8_input});
+		REQUIRE(utf16_length.has_value() == utf16_expected.has_value());
+		if (utf16_length) {
+			utf16_output.resize(*utf16_length);
+			REQUIRE(utf16_output == *utf16_expected);
+			REQUIRE(avo::unicode::utf16_length_of(utf8_input) == *utf16_length);
+		}
+
+		auto utf8_output = std::string(utf16_input.size()*3, '\0');
+		auto const utf8_length = avo::unicode::utf16_to_utf8(utf16_input, utf8_output);
+		auto const utf8_expected = convert_with_iconv<char>("UTF-8", "UTF-16LE", std::u16string_view{utf16_input});
+		REQUIRE(utf8_length.has_value() == utf8_expected.has_value());
+		if (utf8_length) {
+			utf8_output.resize(*utf8_length);
+			REQUIRE(utf8_output == *utf8_expected);
+			REQUIRE(avo::unicode::utf8_length_of(utf16_input) == *utf8_length);
+		}
+	}
+}
+#endif